@@ -1 +1 @@
-src\gen.exe markdown rdunnington.github.io
\ No newline at end of file
+src\gen.exe --template templates\page.html markdown rdunnington.github.io
\ No newline at end of file
@@ -0,0 +1,326 @@
+// Writes a synthetic markdown corpus for benchmarking gen. The same seed always produces the same
+// files, and every file only uses markdown that gen can parse.
+//	corpus <seed> <file count> <bytes per file> <output folder>
+// Or writes the worst cases for gen's parser, one folder per case, to check it stays linear:
+//	corpus --worst <bytes per file> <output folder>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#if defined(_WIN32)
+	#include <direct.h>
+	#define corpus_mkdir(path) _mkdir(path)
+#else
+	#include <sys/stat.h>
+	#define corpus_mkdir(path) mkdir(path, 0755)
+#endif
+
+// 1000 files per folder keeps directory listings reasonable at 100k files
+#define CORPUS_FILES_PER_FOLDER 1000
+
+static const char* WORDS[] =
+{
+	"the", "allocator", "frame", "memory", "render", "thread", "lock", "buffer",
+	"a", "pipeline", "shader", "of", "and", "cache", "line", "to",
+	"in", "engine", "job", "data", "layout", "struct", "pointer", "is",
+	"latency", "bandwidth", "handle", "pool", "for", "with", "asset", "build",
+	"it's", "\"quoted\"", "R&D", "compile", "link", "page", "system", "game",
+};
+
+static const char* CODE_LINES[] =
+{
+	"int main(int argc, char** argv)",
+	"{",
+	"\tfor (int i = 0; i < argc && argv[i] != NULL; ++i) {",
+	"\t\tprintf(\"%s\\n\", argv[i]);",
+	"\t}",
+	"\tstruct buffer* b = buffer_init(&allocator, 1 << 16);",
+	"\treturn a > b ? a : b;",
+	"}",
+};
+
+// Each file is the prefix, the pattern repeated until it's the requested size, the suffix, then
+// the closer once per pattern to unwind any nesting
+struct worst_case
+{
+	const char* name;
+	const char* prefix;
+	const char* pattern;
+	const char* suffix;
+	const char* closer;
+};
+
+static const struct worst_case WORST_CASES[] =
+{
+	{ "brackets", "", "[", "", NULL },
+	{ "unclosed_links", "", "[a](b ", "", NULL },
+	{ "unclosed_link_text", "", "a [b ", "", NULL },
+	{ "underscores", "", " _", "", NULL },
+	{ "unclosed_emphasis", "", "a _b ", "", NULL },
+	{ "backticks", "", "`", "", NULL },
+	{ "unclosed_code_spans", "", "a `b ", "", NULL },
+	{ "fences", "", "```\n", "", NULL },
+	{ "angle_brackets", "", "<", "", NULL },
+	{ "unclosed_tags", "", "<div>\n", "", NULL },
+	{ "nested_tags", "", "<div>\n", "", "</div>" },
+	{ "hashes", "", "#", "", NULL },
+	{ "quote_lines", "", "> a\n", "", NULL },
+	{ "nested_quotes", "", ">", "", NULL },
+	{ "list_items", "", "* a\n", "", NULL },
+	{ "asterisks", "", "*", "", NULL },
+	{ "mixed_openers", "", "[_<`", "", NULL },
+	{ "newlines", "", "\n", "", NULL },
+	{ "unclosed_code_comments", "```c\n", "/* a\n", "```\n", NULL },
+	{ "unclosed_code_strings", "```c\n", "\"a '\n", "```\n", NULL },
+	{ "continued_code_macros", "```c\n", "#define a \\\n", "```\n", NULL },
+	{ "code_keys", "```yaml\n", "aaaaaaaa\n", "```\n", NULL },
+};
+
+// Creates the folder and any missing parents
+static bool make_folders(const char* path)
+{
+	char partial[4096];
+	snprintf(partial, sizeof(partial), "%s", path);
+	for (char* next = partial + 1; *next; ++next) {
+		if (*next == '/') {
+			*next = '\0';
+			corpus_mkdir(partial);
+			*next = '/';
+		}
+	}
+	return corpus_mkdir(partial) == 0 || errno == EEXIST;
+}
+
+struct rng
+{
+	uint64_t state;
+};
+
+// xorshift64*
+static uint32_t rng_next(struct rng* rng)
+{
+	rng->state ^= rng->state >> 12;
+	rng->state ^= rng->state << 25;
+	rng->state ^= rng->state >> 27;
+	return (uint32_t)((rng->state * 2685821657736338717ull) >> 32);
+}
+
+static uint32_t rng_range(struct rng* rng, uint32_t min, uint32_t max)
+{
+	return min + rng_next(rng) % (max - min + 1);
+}
+
+static size_t write_words(FILE* file, struct rng* rng, uint32_t count)
+{
+	size_t written = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		written += (size_t)fprintf(file, i == 0 ? "%s" : " %s", WORDS[rng_next(rng) % (sizeof(WORDS) / sizeof(*WORDS))]);
+	}
+	return written;
+}
+
+// Inline markup is only ever placed after a space, since gen treats underscores that follow a
+// letter as part of the word.
+static size_t write_paragraph(FILE* file, struct rng* rng)
+{
+	size_t written = write_words(file, rng, rng_range(rng, 3, 8));
+
+	const uint32_t spans = rng_range(rng, 2, 6);
+	for (uint32_t i = 0; i < spans; ++i) {
+		switch (rng_next(rng) % 5)
+		{
+			case 0:
+				written += (size_t)fprintf(file, " _");
+				written += write_words(file, rng, rng_range(rng, 1, 3));
+				written += (size_t)fprintf(file, "_");
+				break;
+			case 1:
+				written += (size_t)fprintf(file, " __");
+				written += write_words(file, rng, rng_range(rng, 1, 3));
+				written += (size_t)fprintf(file, "__");
+				break;
+			case 2:
+				written += (size_t)fprintf(file, " `buffer[%u] & mask`", rng_next(rng) % 64);
+				break;
+			case 3:
+				written += (size_t)fprintf(file, " [");
+				written += write_words(file, rng, rng_range(rng, 1, 4));
+				written += (size_t)fprintf(file, "](%shttps://example.com/post/%u?a=1&b=2)", (rng_next(rng) & 1) ? "[newtab]" : "", rng_next(rng) % 1000);
+				break;
+			default:
+				break;
+		}
+		written += (size_t)fprintf(file, " ");
+		written += write_words(file, rng, rng_range(rng, 4, 16));
+	}
+
+	written += (size_t)fprintf(file, ".\n\n");
+	return written;
+}
+
+static size_t write_block(FILE* file, struct rng* rng)
+{
+	size_t written = 0;
+	switch (rng_next(rng) % 10)
+	{
+		case 0:
+			written += (size_t)fprintf(file, "%.*s ", (int)rng_range(rng, 2, 3), "###");
+			written += write_words(file, rng, rng_range(rng, 2, 6));
+			written += (size_t)fprintf(file, "\n\n");
+			break;
+		case 1:
+		{
+			const uint32_t items = rng_range(rng, 2, 6);
+			for (uint32_t i = 0; i < items; ++i) {
+				written += (size_t)fprintf(file, "* ");
+				written += write_words(file, rng, rng_range(rng, 3, 12));
+				written += (size_t)fprintf(file, "\n");
+			}
+			written += (size_t)fprintf(file, "\n");
+			break;
+		}
+		case 2:
+		{
+			const uint32_t lines = rng_range(rng, 1, 3);
+			for (uint32_t i = 0; i < lines; ++i) {
+				written += (size_t)fprintf(file, "> ");
+				written += write_words(file, rng, rng_range(rng, 5, 15));
+				written += (size_t)fprintf(file, "\n");
+			}
+			written += (size_t)fprintf(file, "\n");
+			break;
+		}
+		case 3:
+		{
+			written += (size_t)fprintf(file, "```c\n");
+			const uint32_t lines = rng_range(rng, 4, 24);
+			for (uint32_t i = 0; i < lines; ++i) {
+				written += (size_t)fprintf(file, "%s\n", CODE_LINES[rng_next(rng) % (sizeof(CODE_LINES) / sizeof(*CODE_LINES))]);
+			}
+			written += (size_t)fprintf(file, "```\n\n");
+			break;
+		}
+		case 4:
+			// gen counts every opening tag inside an html block but only closing tags of the outer kind,
+			// so nested blocks are all divs like the resume's headers
+			written += (size_t)fprintf(file, "<div class=\"figure\">\n\t<div class=\"figure-title\">Figure %u</div>\n\t<div class=\"figure-caption\">", rng_next(rng) % 100);
+			written += write_words(file, rng, rng_range(rng, 3, 10));
+			written += (size_t)fprintf(file, "</div>\n</div>\n\n");
+			break;
+		default:
+			written += write_paragraph(file, rng);
+			break;
+	}
+	return written;
+}
+
+static bool write_page(const char* path, struct rng* rng, size_t size)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	size_t written = (size_t)fprintf(file, "# ");
+	written += write_words(file, rng, rng_range(rng, 2, 6));
+	written += (size_t)fprintf(file, "\n\n");
+
+	while (written < size) {
+		written += write_block(file, rng);
+	}
+
+	const bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+static bool write_worst_case(const char* path, const struct worst_case* worst, size_t size)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+
+	size_t written = (size_t)fprintf(file, "# %s\n\n%s", worst->name, worst->prefix);
+	size_t repeats = 0;
+	while (written < size) {
+		written += (size_t)fprintf(file, "%s", worst->pattern);
+		++repeats;
+	}
+	fprintf(file, "%s", worst->suffix);
+	for (size_t i = 0; worst->closer && i < repeats; ++i) {
+		fprintf(file, "%s", worst->closer);
+	}
+
+	const bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+static int write_worst_cases(size_t file_size, const char* path_output)
+{
+	char path[4096];
+	for (size_t i = 0; i < sizeof(WORST_CASES) / sizeof(*WORST_CASES); ++i) {
+		snprintf(path, sizeof(path), "%s/%s", path_output, WORST_CASES[i].name);
+		if (!make_folders(path)) {
+			printf("Failed to create '%s': %s\n", path, strerror(errno));
+			return 1;
+		}
+
+		snprintf(path, sizeof(path), "%s/%s/%s.md", path_output, WORST_CASES[i].name, WORST_CASES[i].name);
+		if (!write_worst_case(path, WORST_CASES + i, file_size)) {
+			printf("Failed to write '%s'\n", path);
+			return 1;
+		}
+	}
+
+	printf("Wrote %zu worst cases of ~%zu bytes to %s\n", sizeof(WORST_CASES) / sizeof(*WORST_CASES), file_size, path_output);
+	return 0;
+}
+
+int main(int argc, const char** argv)
+{
+	if (argc == 4 && !strcmp(argv[1], "--worst")) {
+		return write_worst_cases((size_t)strtoull(argv[2], NULL, 10), argv[3]);
+	}
+
+	if (argc != 5) {
+		printf("Usage: %s <seed> <file count> <bytes per file> <output folder>\n", argv[0]);
+		printf("       %s --worst <bytes per file> <output folder>\n", argv[0]);
+		return 1;
+	}
+
+	const uint64_t seed = strtoull(argv[1], NULL, 10);
+	const uint32_t file_count = (uint32_t)strtoul(argv[2], NULL, 10);
+	const size_t file_size = (size_t)strtoull(argv[3], NULL, 10);
+	const char* path_output = argv[4];
+
+	if (!make_folders(path_output)) {
+		printf("Failed to create '%s': %s\n", path_output, strerror(errno));
+		return 1;
+	}
+
+	char path[4096];
+	for (uint32_t i = 0; i < file_count; ++i) {
+		if (i % CORPUS_FILES_PER_FOLDER == 0) {
+			snprintf(path, sizeof(path), "%s/%03u", path_output, i / CORPUS_FILES_PER_FOLDER);
+			corpus_mkdir(path);
+		}
+
+		// Seeded per file so any one file can be regenerated without the others
+		struct rng rng = { .state = (seed + 1) * 0x9E3779B97F4A7C15ull ^ ((uint64_t)i + 1) * 0xBF58476D1CE4E5B9ull };
+
+		snprintf(path, sizeof(path), "%s/%03u/%05u.md", path_output, i / CORPUS_FILES_PER_FOLDER, i);
+		if (!write_page(path, &rng, file_size)) {
+			printf("Failed to write '%s'\n", path);
+			return 1;
+		}
+	}
+
+	printf("Wrote %u files of ~%zu bytes to %s\n", file_count, file_size, path_output);
+	return 0;
+}
@@ -0,0 +1,73 @@
+// Renders markdown to html in memory, the same way the gen CLI renders a page, without touching
+// the filesystem. Build it as a library with `make lib`, which is main.c without its main().
+//
+//	struct gen_diagnostic error;
+//	struct gen_renderer* renderer = gen_renderer_create(&(struct gen_renderer_desc){ .cache_entries = 256 }, &error);
+//	struct gen_page page;
+//	gen_render(renderer, markdown, length, "blog/post.html", &page);
+//	...
+//	gen_renderer_destroy(renderer);
+//
+// A renderer isn't thread safe. Services rendering on several threads use one per thread.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+struct gen_renderer;
+
+// Where rendering went wrong. Parsing stops at the first block it can't parse, so a page has at most
+// one, and it's rendered from the blocks before it.
+struct gen_diagnostic
+{
+	const char* message; // static, so it outlives the renderer
+	uint32_t line; // 1-based. 0 if it isn't about a place in the markdown, like a template error.
+	uint32_t column; // 1-based, in bytes
+};
+
+struct gen_renderer_desc
+{
+	const char* template_text; // the page template, NULL for the built-in one. Copied.
+	size_t template_length;
+	bool minify; // as gen --minify
+	bool body_only; // render the markdown without the template around it
+
+	// Rendered pages are kept, keyed by a hash of the markdown and path, until one of these limits
+	// pushes out the least recently used. 0 entries turns the cache off.
+	uint32_t cache_entries;
+	size_t cache_bytes; // 0 for no limit but the entry count
+};
+
+struct gen_page
+{
+	const char* html;
+	size_t html_length;
+	const char* title; // plain text of the first header, "" if there isn't one
+	const char* summary; // plain text of the first paragraph
+	const struct gen_diagnostic* diagnostics;
+	uint32_t diagnostic_count;
+	bool cached; // rendered by an earlier call
+};
+
+struct gen_cache_stats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint32_t entries;
+	size_t bytes;
+};
+
+// Returns NULL if the template doesn't parse or it's out of memory, with why in error, which may be NULL
+struct gen_renderer* gen_renderer_create(const struct gen_renderer_desc* desc, struct gen_diagnostic* error);
+void gen_renderer_destroy(struct gen_renderer* renderer);
+
+// path is the page's path from the site root, like "blog/2020-05-18/page.html", for the template's
+// {{path}}, {{root}} and {{date}}. It may be NULL for a page at the root. The page's strings are
+// valid until the next gen_render() or gen_renderer_destroy() with the same renderer. Returns
+// false if the markdown has a diagnostic.
+bool gen_render(struct gen_renderer* renderer, const char* markdown, size_t length, const char* path, struct gen_page* out);
+
+struct gen_cache_stats gen_renderer_cache_stats(const struct gen_renderer* renderer);
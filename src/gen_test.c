@@ -0,0 +1,163 @@
+// Checks the gen.h API against libgen.a. make libtest builds and runs it, and it exits with 1 if any
+// check fails.
+
+#include "gen.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			++failures; \
+		} \
+	} while (0)
+
+static bool render(struct gen_renderer* renderer, const char* markdown, const char* path, struct gen_page* page)
+{
+	return gen_render(renderer, markdown, strlen(markdown), path, page);
+}
+
+static void test_template_error(void)
+{
+	struct gen_diagnostic error = {0};
+	const char template[] = "<html>no body</html>";
+	struct gen_renderer_desc desc = { .template_text = template, .template_length = sizeof(template) - 1 };
+	CHECK(gen_renderer_create(&desc, &error) == NULL);
+	CHECK(error.message != NULL);
+	CHECK(error.line == 0);
+}
+
+static void test_render(void)
+{
+	struct gen_diagnostic error = {0};
+	struct gen_renderer* renderer = gen_renderer_create(&(struct gen_renderer_desc){ .cache_entries = 8 }, &error);
+	CHECK(renderer != NULL);
+	if (renderer == NULL) {
+		return;
+	}
+
+	const char* markdown = "# Hello _world_\n\nFirst paragraph.\n\n* a\n* b\n";
+	struct gen_page page;
+	CHECK(render(renderer, markdown, "blog/2020-05-18/post.html", &page));
+	CHECK(!page.cached);
+	CHECK(page.diagnostic_count == 0);
+	CHECK(strlen(page.html) == page.html_length);
+	CHECK(strstr(page.html, "<!DOCTYPE html>") != NULL);
+	CHECK(strstr(page.html, "<span class=\"text-emphasis-1\">world</span></h1>") != NULL);
+	CHECK(strcmp(page.title, "Hello") == 0);
+	CHECK(strcmp(page.summary, "First paragraph.") == 0);
+	const size_t html_length = page.html_length;
+
+	// The same markdown and path is a hit, and the same markdown at another path isn't
+	CHECK(render(renderer, markdown, "blog/2020-05-18/post.html", &page));
+	CHECK(page.cached);
+	CHECK(page.html_length == html_length);
+	CHECK(strcmp(page.title, "Hello") == 0);
+	CHECK(render(renderer, markdown, NULL, &page));
+	CHECK(!page.cached);
+
+	struct gen_cache_stats stats = gen_renderer_cache_stats(renderer);
+	CHECK(stats.hits == 1);
+	CHECK(stats.misses == 2);
+	CHECK(stats.evictions == 0);
+	CHECK(stats.entries == 2);
+
+	gen_renderer_destroy(renderer);
+}
+
+static void test_diagnostic(void)
+{
+	struct gen_renderer* renderer = gen_renderer_create(&(struct gen_renderer_desc){ .body_only = true, .cache_entries = 8 }, NULL);
+	CHECK(renderer != NULL);
+	if (renderer == NULL) {
+		return;
+	}
+
+	// The fence is never closed, so parsing stops at it and the paragraph before it is still rendered
+	const char* markdown = "A paragraph.\n\n```\nunclosed fence\n";
+	struct gen_page page;
+	CHECK(!render(renderer, markdown, NULL, &page));
+	CHECK(page.diagnostic_count == 1);
+	if (page.diagnostic_count == 1) {
+		CHECK(page.diagnostics[0].message != NULL);
+		CHECK(page.diagnostics[0].line == 3);
+		CHECK(page.diagnostics[0].column == 1);
+	}
+	CHECK(strstr(page.html, "<p>A paragraph.</p>") != NULL);
+
+	// Cached pages keep their diagnostics
+	CHECK(!render(renderer, markdown, NULL, &page));
+	CHECK(page.cached);
+	CHECK(page.diagnostic_count == 1);
+
+	gen_renderer_destroy(renderer);
+}
+
+static void test_eviction(void)
+{
+	struct gen_renderer* renderer = gen_renderer_create(&(struct gen_renderer_desc){ .body_only = true, .cache_entries = 2 }, NULL);
+	CHECK(renderer != NULL);
+	if (renderer == NULL) {
+		return;
+	}
+
+	struct gen_page page;
+	render(renderer, "a\n", NULL, &page);
+	render(renderer, "b\n", NULL, &page);
+	render(renderer, "a\n", NULL, &page); // a is now more recently used than b
+	CHECK(page.cached);
+	render(renderer, "c\n", NULL, &page); // pushes out b
+
+	struct gen_cache_stats stats = gen_renderer_cache_stats(renderer);
+	CHECK(stats.evictions == 1);
+	CHECK(stats.entries == 2);
+
+	render(renderer, "a\n", NULL, &page);
+	CHECK(page.cached);
+	render(renderer, "c\n", NULL, &page);
+	CHECK(page.cached);
+	render(renderer, "b\n", NULL, &page);
+	CHECK(!page.cached);
+	CHECK(strstr(page.html, "<p>b</p>") != NULL);
+
+	gen_renderer_destroy(renderer);
+
+	// The byte limit evicts before the entry count is reached
+	const size_t cache_bytes = 4096;
+	renderer = gen_renderer_create(&(struct gen_renderer_desc){ .cache_entries = 64, .cache_bytes = cache_bytes }, NULL);
+	CHECK(renderer != NULL);
+	if (renderer == NULL) {
+		return;
+	}
+
+	char markdown[64];
+	for (int i = 0; i < 32; ++i) {
+		snprintf(markdown, sizeof(markdown), "# Page %d\n\nText.\n", i);
+		render(renderer, markdown, NULL, &page);
+	}
+	stats = gen_renderer_cache_stats(renderer);
+	CHECK(stats.evictions > 0);
+	CHECK(stats.entries < 32);
+	CHECK(stats.bytes <= cache_bytes);
+
+	gen_renderer_destroy(renderer);
+}
+
+int main(void)
+{
+	test_template_error();
+	test_render();
+	test_diagnostic();
+	test_eviction();
+
+	if (failures > 0) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
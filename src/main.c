@@ -1,12 +1,107 @@
+#if defined(__linux__)
+	#define _GNU_SOURCE // copy_file_range
+#endif
+
 #include <stdio.h>
 #include <memory.h>
 #include <ctype.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define GEN_TOKENIZER_X64 1
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define GEN_TOKENIZER_NEON 1
+	#include <arm_neon.h>
+#endif
+
+#if defined(__linux__)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/ioctl.h>
+	#include <sys/mman.h>
+	#include <sys/sendfile.h>
+	#include <sys/uio.h>
+	#include <sys/inotify.h>
+	#include <linux/fs.h>
+	#include <poll.h>
+	#include <errno.h>
+	#include <signal.h>
+	#include <sys/epoll.h>
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+#elif defined(__APPLE__)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/uio.h>
+	#include <copyfile.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+	#define GEN_POSIX 1
+#endif
+
+// for the one-time setup of the gen.h API
+#if GEN_POSIX
+	#include <pthread.h>
+#elif defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#endif
+
+// Precompressed .gz outputs need zlib, which Linux and macOS both ship. .zst outputs need libzstd,
+// so they're only built with GEN_ZSTD=1 (make ZSTD=1).
+#if !defined(GEN_GZIP)
+	#if GEN_POSIX
+		#define GEN_GZIP 1
+	#else
+		#define GEN_GZIP 0
+	#endif
+#endif
+
+#if !defined(GEN_ZSTD)
+	#define GEN_ZSTD 0
+#endif
+
+// make lib builds this file with GEN_LIBRARY=1 for the gen.h API, which leaves out main()
+#if !defined(GEN_LIBRARY)
+	#define GEN_LIBRARY 0
+#endif
+
+// Everything outside gen.h is GEN_INTERNAL, which is static in the library so its names don't
+// collide with the program linking it. Whatever only main() uses is unreferenced there.
+#if GEN_LIBRARY
+	#if defined(_MSC_VER)
+		#pragma warning(disable : 4505) // unreferenced function with internal linkage
+		#define GEN_INTERNAL static
+	#else
+		#define GEN_INTERNAL static __attribute__((unused))
+	#endif
+#else
+	#define GEN_INTERNAL
+#endif
+
+#if GEN_GZIP
+	#include <zlib.h>
+#endif
+#if GEN_ZSTD
+	#include <zstd.h>
+#endif
 
 #define RJD_ENABLE_LOGGING 1
 #define RJD_ENABLE_ASSERT 1
 #define RJD_GFX_BACKEND_NONE 1
 #include "rjd/rjd_all.h"
 
+#include "gen.h"
+
 enum token_type
 {
 	TOKEN_TYPE_TEXT,
@@ -25,23 +120,23 @@ enum token_type
 	TOKEN_TYPE_COUNT,
 };
 
-const char TOKEN_SYMBOLS[] =
+// Token type that each byte starts. Bytes that aren't symbols are TOKEN_TYPE_TEXT (0).
+GEN_INTERNAL const uint8_t TOKEN_CLASSES[256] =
 {
-	0,
-	'\n',
-	'#',
-	'*',
-	'[',
-	']',
-	'(',
-	')',
-	'<',
-	'>',
-	'/',
-	'`',
-	'_',
+	['\n'] = TOKEN_TYPE_NEWLINE,
+	['#'] = TOKEN_TYPE_HASH,
+	['*'] = TOKEN_TYPE_ASTERISK,
+	['['] = TOKEN_TYPE_SQUARE_BRACKET_OPEN,
+	[']'] = TOKEN_TYPE_SQUARE_BRACKET_CLOSE,
+	['('] = TOKEN_TYPE_PAREN_OPEN,
+	[')'] = TOKEN_TYPE_PAREN_CLOSE,
+	['<'] = TOKEN_TYPE_ANGLE_BRACKET_OPEN,
+	['>'] = TOKEN_TYPE_ANGLE_BRACKET_CLOSE,
+	['/'] = TOKEN_TYPE_SLASH_FORWARD,
+	['`'] = TOKEN_TYPE_BACKTICK,
+	['_'] = TOKEN_TYPE_UNDERSCORE,
 };
-RJD_STATIC_ASSERT(rjd_countof(TOKEN_SYMBOLS) == TOKEN_TYPE_COUNT);
+RJD_STATIC_ASSERT(TOKEN_TYPE_TEXT == 0);
 
 struct token
 {
@@ -50,814 +145,7142 @@ struct token
 	enum token_type type;
 };
 
-struct token_stream
-{
-	const struct token* tokens;
-	const struct token* first_header_text;
-	uint32_t cursor;
-	int32_t indent;
-};
+// Plain text makes up most of a markdown file, so the tokenizer's hot loop is finding the next symbol
+// byte. The scalar version looks each byte up in TOKEN_CLASSES, and the SIMD versions check 16 or 32
+// bytes at a time. SSE2 compares against each symbol. AVX2 and NEON have a byte shuffle, so they split
+// each byte into nibbles and look both up in 16-entry tables instead: every distinct high nibble of a
+// symbol gets its own bit, and the low nibble table holds the bits of the high nibbles it pairs with.
+// A byte is a symbol if its two lookups share a bit.
+typedef const char* find_token_symbol_func(const char* next, const char* end);
 
-enum paragraph_position
+struct tokenizer_tables
 {
-	PARAGRAPH_POSITION_ROOT,
-	PARAGRAPH_POSITION_INLINE,
+	uint8_t nibble_lo[16];
+	uint8_t nibble_hi[16];
+	char symbols[TOKEN_TYPE_COUNT];
+	uint32_t symbol_count;
 };
 
-void append_indent(struct rjd_strbuf* out, const struct token_stream* stream);
-bool peek_token(const struct token_stream* stream, enum token_type type);
-bool stream_finished(const struct token_stream* stream);
-struct rjd_result advance_token(struct token_stream* stream);
-struct rjd_result consume_token(struct token_stream* stream, enum token_type type);
-struct rjd_result parse_text(struct rjd_strbuf* out, struct token_stream* stream);
-struct rjd_result parse_paragraph(struct rjd_strbuf* out, struct token_stream* stream);
-struct rjd_result parse_header(struct rjd_strbuf* out, struct token_stream* stream);
-struct rjd_result parse_list(struct rjd_strbuf* out, struct token_stream* stream);
-struct rjd_result parse_link(struct rjd_strbuf* out, struct token_stream* stream);
-struct rjd_result parse_html(struct rjd_strbuf* out, struct token_stream* stream);
-struct rjd_result parse_quote(struct rjd_strbuf* out, struct token_stream* stream); 
-struct rjd_result parse_code(struct rjd_strbuf* out, struct token_stream* stream, enum paragraph_position paragraph_position); 
-struct rjd_result parse_emphasis(struct rjd_strbuf* out, struct token_stream* stream);
+static struct tokenizer_tables TOKENIZER_TABLES;
+static find_token_symbol_func* find_token_symbol = NULL;
 
-void append_indent(struct rjd_strbuf* out, const struct token_stream* stream)
+static inline uint32_t count_trailing_zeros(uint64_t value)
 {
-	if (stream->indent < 0) {
-		printf("stream indent went negative! value: %d", stream->indent);
-	}
-	for (int i = 0; i < stream->indent; ++i)
-	{
-		rjd_strbuf_append(out, "\t");
-	}
+#if defined(_MSC_VER)
+	unsigned long index = 0;
+	_BitScanForward64(&index, value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctzll(value);
+#endif
 }
 
-void append_token_text(struct rjd_strbuf* out, const struct token* t)
+static const char* find_token_symbol_scalar(const char* next, const char* end)
 {
-	for (uint32_t i = 0; i < t->length; ++i) {
-		switch (t->text[i]) {
-			case '<':
-				rjd_strbuf_append(out, "&lt;");
-				break;
-			case '>':
-				rjd_strbuf_append(out, "&gt;");
-				break;
-			default:
-				rjd_strbuf_appendl(out, t->text + i, 1);
-				break;
-		}
+	while (next < end && TOKEN_CLASSES[(uint8_t)*next] == TOKEN_TYPE_TEXT) {
+		++next;
 	}
+	return next;
 }
 
-bool stream_finished(const struct token_stream* stream)
+#if GEN_TOKENIZER_X64
+static const char* find_token_symbol_sse2(const char* next, const char* end)
 {
-	if (stream->cursor >= rjd_array_count(stream->tokens)) {
-		return true;
+	__m128i symbols[TOKEN_TYPE_COUNT];
+	for (uint32_t i = 0; i < TOKENIZER_TABLES.symbol_count; ++i) {
+		symbols[i] = _mm_set1_epi8(TOKENIZER_TABLES.symbols[i]);
 	}
-	return false;
-}
 
-bool peek_token(const struct token_stream* stream, enum token_type type)
-{
-	uint32_t cursor = stream->cursor + 1;
-	if (cursor >= rjd_array_count(stream->tokens)) {
-		return true;
-	}
-	if (stream->tokens[cursor].type != type) {
-		return false;
+	while (end - next >= 16)
+	{
+		const __m128i chunk = _mm_loadu_si128((const __m128i*)next);
+		__m128i hits = _mm_setzero_si128();
+		for (uint32_t i = 0; i < TOKENIZER_TABLES.symbol_count; ++i) {
+			hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, symbols[i]));
+		}
+
+		const uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+		if (mask) {
+			return next + count_trailing_zeros(mask);
+		}
+		next += 16;
 	}
-	return true;
+
+	return find_token_symbol_scalar(next, end);
 }
 
-struct rjd_result advance_token(struct token_stream* stream)
+#if !defined(_MSC_VER)
+__attribute__((target("avx2")))
+#endif
+static const char* find_token_symbol_avx2(const char* next, const char* end)
 {
-	++stream->cursor;
-	if (stream->cursor >= rjd_array_count(stream->tokens)) {
-		return RJD_RESULT("end of token stream");
+	const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)TOKENIZER_TABLES.nibble_lo));
+	const __m256i hi_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)TOKENIZER_TABLES.nibble_hi));
+	const __m256i low_mask = _mm256_set1_epi8(0x0f);
+	const __m256i zero = _mm256_setzero_si256();
+
+	while (end - next >= 32)
+	{
+		const __m256i chunk = _mm256_loadu_si256((const __m256i*)next);
+		const __m256i lo_bits = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(chunk, low_mask));
+		const __m256i hi_bits = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), low_mask));
+		const __m256i misses = _mm256_cmpeq_epi8(_mm256_and_si256(lo_bits, hi_bits), zero);
+
+		const uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(misses);
+		if (mask) {
+			return next + count_trailing_zeros(mask);
+		}
+		next += 32;
 	}
 
-	return RJD_RESULT_OK();
+	return find_token_symbol_sse2(next, end);
 }
 
-struct rjd_result consume_token(struct token_stream* stream, enum token_type type)
+static bool cpu_supports_avx2(void)
 {
-	advance_token(stream);
-	if (stream->tokens[stream->cursor].type != type) {
-		return RJD_RESULT("consume_token: unexpected token");
+#if defined(_MSC_VER)
+	int info[4] = {0};
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
 	}
-	return RJD_RESULT_OK();
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool os_saves_ymm = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+	__cpuidex(info, 7, 0);
+	return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
 }
+#endif // GEN_TOKENIZER_X64
 
-struct rjd_result parse_text(struct rjd_strbuf* out, struct token_stream* stream)
+#if GEN_TOKENIZER_NEON
+static const char* find_token_symbol_neon(const char* next, const char* end)
 {
-	bool consuming = true;
-	while (consuming && !stream_finished(stream))
+	const uint8x16_t lo_table = vld1q_u8(TOKENIZER_TABLES.nibble_lo);
+	const uint8x16_t hi_table = vld1q_u8(TOKENIZER_TABLES.nibble_hi);
+	const uint8x16_t low_mask = vdupq_n_u8(0x0f);
+
+	while (end - next >= 16)
 	{
-		const struct token* t = stream->tokens + stream->cursor;
-		switch (t->type)
-		{
-			case TOKEN_TYPE_TEXT:
-				rjd_strbuf_appendl(out, t->text, t->length);
-				break;
-			case TOKEN_TYPE_SLASH_FORWARD:
-			case TOKEN_TYPE_PAREN_OPEN:
-			case TOKEN_TYPE_PAREN_CLOSE:
-				rjd_strbuf_appendl(out, t->text, t->length);
-				break;
-			case TOKEN_TYPE_SQUARE_BRACKET_OPEN:
-				RJD_RESULT_PROMOTE(parse_link(out, stream));
-				break;
-			case TOKEN_TYPE_BACKTICK:
-				RJD_RESULT_PROMOTE(parse_code(out, stream, PARAGRAPH_POSITION_INLINE));
-				break;
-			case TOKEN_TYPE_UNDERSCORE:
-				RJD_RESULT_PROMOTE(parse_emphasis(out, stream));
-				break;
-			default:
-				consuming = false;
-				break;
+		const uint8x16_t chunk = vld1q_u8((const uint8_t*)next);
+		const uint8x16_t lo_bits = vqtbl1q_u8(lo_table, vandq_u8(chunk, low_mask));
+		const uint8x16_t hi_bits = vqtbl1q_u8(hi_table, vshrq_n_u8(chunk, 4));
+		const uint8x16_t hits = vtstq_u8(lo_bits, hi_bits);
+
+		// narrow each byte of the compare result to a nibble to get a 64-bit mask
+		const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+		if (mask) {
+			return next + count_trailing_zeros(mask) / 4;
 		}
-		advance_token(stream);
+		next += 16;
 	}
 
-	return RJD_RESULT_OK();
+	return find_token_symbol_scalar(next, end);
 }
+#endif
 
-struct rjd_result parse_paragraph(struct rjd_strbuf* out, struct token_stream* stream)
+// Text emitted into a page goes through append_html_escaped(). Most text has nothing to escape, so
+// like the tokenizer, it finds the next special character 16 or 32 bytes at a time and copies the
+// clean run before it in one go.
+GEN_INTERNAL const char* const HTML_ESCAPES[256] =
 {
-	append_indent(out, stream);
+	['&'] = "&amp;",
+	['<'] = "&lt;",
+	['>'] = "&gt;",
+	['"'] = "&quot;",
+	['\''] = "&#39;",
+};
 
-	// Backticks count as plain text because if we've landed in this case with a backtick, we're
-	// going to make an inline code span.
-	bool is_plain_text = 
-		stream->tokens[stream->cursor].type == TOKEN_TYPE_TEXT ||
-		stream->tokens[stream->cursor].type == TOKEN_TYPE_BACKTICK ||
-		stream->tokens[stream->cursor].type == TOKEN_TYPE_UNDERSCORE;
+typedef const char* find_html_special_func(const char* next, const char* end);
+static find_html_special_func* find_html_special = NULL;
 
-	if (is_plain_text) {
-		rjd_strbuf_append(out, "<p>");
+static const char* find_html_special_scalar(const char* next, const char* end)
+{
+	while (next < end && HTML_ESCAPES[(uint8_t)*next] == NULL) {
+		++next;
 	}
+	return next;
+}
 
-	parse_text(out, stream);
+#if GEN_TOKENIZER_X64
+static const char* find_html_special_sse2(const char* next, const char* end)
+{
+	const __m128i amp = _mm_set1_epi8('&');
+	const __m128i lt = _mm_set1_epi8('<');
+	const __m128i gt = _mm_set1_epi8('>');
+	const __m128i quot = _mm_set1_epi8('"');
+	const __m128i apos = _mm_set1_epi8('\'');
 
-	if (is_plain_text) {
-		rjd_strbuf_append(out, "</p>");
+	while (end - next >= 16)
+	{
+		const __m128i chunk = _mm_loadu_si128((const __m128i*)next);
+		__m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, gt));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, quot));
+		hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, apos));
+
+		const uint32_t mask = (uint32_t)_mm_movemask_epi8(hits);
+		if (mask) {
+			return next + count_trailing_zeros(mask);
+		}
+		next += 16;
 	}
-	rjd_strbuf_append(out, "\n");
 
-	return RJD_RESULT_OK();
+	return find_html_special_scalar(next, end);
 }
 
-struct rjd_result parse_header(struct rjd_strbuf* out, struct token_stream* stream)
+#if !defined(_MSC_VER)
+__attribute__((target("avx2")))
+#endif
+static const char* find_html_special_avx2(const char* next, const char* end)
 {
-	const struct token* t = stream->tokens + stream->cursor;
-
-	RJD_ASSERT(t->type == TOKEN_TYPE_HASH);
-
-	int32_t header_type = 0;
-
-	while (t->type == TOKEN_TYPE_HASH) {
-		++header_type;
-		RJD_RESULT_PROMOTE(advance_token(stream));
-		t = stream->tokens + stream->cursor;
-	}
+	const __m256i amp = _mm256_set1_epi8('&');
+	const __m256i lt = _mm256_set1_epi8('<');
+	const __m256i gt = _mm256_set1_epi8('>');
+	const __m256i quot = _mm256_set1_epi8('"');
+	const __m256i apos = _mm256_set1_epi8('\'');
 
-	if (stream->first_header_text == NULL) {
-		stream->first_header_text = t;
+	while (end - next >= 32)
+	{
+		const __m256i chunk = _mm256_loadu_si256((const __m256i*)next);
+		__m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, amp), _mm256_cmpeq_epi8(chunk, lt));
+		hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, gt));
+		hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, quot));
+		hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, apos));
+
+		const uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+		if (mask) {
+			return next + count_trailing_zeros(mask);
+		}
+		next += 32;
 	}
 
-	append_indent(out, stream);
-	rjd_strbuf_append(out, "<h%d>", header_type);
-	RJD_RESULT_PROMOTE(parse_text(out, stream));
-	rjd_strbuf_append(out, "</h%d>\n", header_type);
-
-	return RJD_RESULT_OK();
+	return find_html_special_sse2(next, end);
 }
+#endif
 
-struct rjd_result parse_list(struct rjd_strbuf* out, struct token_stream* stream)
+#if GEN_TOKENIZER_NEON
+static const char* find_html_special_neon(const char* next, const char* end)
 {
-	const struct token* t = stream->tokens + stream->cursor;
-
-	RJD_ASSERT(t->type == TOKEN_TYPE_ASTERISK);
-	append_indent(out, stream);
-	rjd_strbuf_append(out, "<ul>\n");
-
-	stream->indent += 1;
+	const uint8x16_t amp = vdupq_n_u8('&');
+	const uint8x16_t lt = vdupq_n_u8('<');
+	const uint8x16_t gt = vdupq_n_u8('>');
+	const uint8x16_t quot = vdupq_n_u8('"');
+	const uint8x16_t apos = vdupq_n_u8('\'');
 
-	while (true)
+	while (end - next >= 16)
 	{
-		append_indent(out, stream);
-		rjd_strbuf_append(out, "<li>");
-	
-		RJD_RESULT_PROMOTE(advance_token(stream));
-		parse_text(out, stream);
-		rjd_strbuf_append(out, "</li>\n");
-		stream->cursor -= 1;
-
-		if (!rjd_result_isok(consume_token(stream, TOKEN_TYPE_ASTERISK))) {
-			break;
+		const uint8x16_t chunk = vld1q_u8((const uint8_t*)next);
+		uint8x16_t hits = vorrq_u8(vceqq_u8(chunk, amp), vceqq_u8(chunk, lt));
+		hits = vorrq_u8(hits, vceqq_u8(chunk, gt));
+		hits = vorrq_u8(hits, vceqq_u8(chunk, quot));
+		hits = vorrq_u8(hits, vceqq_u8(chunk, apos));
+
+		const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+		if (mask) {
+			return next + count_trailing_zeros(mask) / 4;
 		}
+		next += 16;
 	}
 
-	stream->indent -= 1;
-
-	append_indent(out, stream);
-	rjd_strbuf_append(out, "</ul>\n");
-
-	return RJD_RESULT_OK();
+	return find_html_special_scalar(next, end);
 }
+#endif
 
-struct rjd_result parse_link(struct rjd_strbuf* out, struct token_stream* stream)
+// Safe for both element text and quoted attribute values
+GEN_INTERNAL void append_html_escaped(struct rjd_strbuf* out, const char* text, size_t length)
 {
-	const struct token* t = stream->tokens + stream->cursor;
-	RJD_ASSERT(t->type == TOKEN_TYPE_SQUARE_BRACKET_OPEN);
-
-	bool open_new_tab = false;
-	const struct token* link_text_start = t + 1;
+	const char* end = text + length;
+	while (text < end)
+	{
+		const char* special = find_html_special(text, end);
+		if (special > text) {
+			rjd_strbuf_appendl(out, text, (uint32_t)(special - text));
+		}
+		if (special == end) {
+			break;
+		}
 
-	while (!peek_token(stream, TOKEN_TYPE_SQUARE_BRACKET_CLOSE)) {
-		advance_token(stream);
+		const char* escaped = HTML_ESCAPES[(uint8_t)*special];
+		rjd_strbuf_appendl(out, escaped, (uint32_t)strlen(escaped));
+		text = special + 1;
 	}
-	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SQUARE_BRACKET_CLOSE));
+}
 
-	const struct token* link_text_end = stream->tokens + stream->cursor;
+enum text_scan_isa
+{
+	TEXT_SCAN_ISA_DETECT,
+	TEXT_SCAN_ISA_SCALAR,
+	TEXT_SCAN_ISA_SSE2,
+	TEXT_SCAN_ISA_AVX2,
+	TEXT_SCAN_ISA_NEON,
+};
 
-	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_PAREN_OPEN));
+// Must be called before tokenize() or append_html_escaped(). Picks the widest scanners the CPU supports
+// unless an ISA is requested.
+GEN_INTERNAL void text_scan_init(enum text_scan_isa isa)
+{
+	struct tokenizer_tables tables = {0};
 
-	if (peek_token(stream, TOKEN_TYPE_SQUARE_BRACKET_OPEN)) {
-		RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SQUARE_BRACKET_OPEN));
-		RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_TEXT));
+	uint8_t hi_bit_count = 0;
+	for (uint32_t c = 0; c < rjd_countof(TOKEN_CLASSES); ++c) {
+		if (TOKEN_CLASSES[c] == TOKEN_TYPE_TEXT) {
+			continue;
+		}
 
-		const struct token* attribute = stream->tokens + stream->cursor;
+		tables.symbols[tables.symbol_count++] = (char)c;
 
-		if (!strncmp("newtab", attribute->text, attribute->length)) {
-			open_new_tab = true;
-		} else {
-			return RJD_RESULT("unknown link attribute");
+		const uint8_t lo = c & 0xf;
+		const uint8_t hi = (uint8_t)(c >> 4);
+		if (tables.nibble_hi[hi] == 0) {
+			RJD_ASSERTMSG(hi_bit_count < 8, "Token symbols span too many high nibbles for the SIMD lookup tables");
+			tables.nibble_hi[hi] = (uint8_t)(1 << hi_bit_count++);
 		}
-		RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SQUARE_BRACKET_CLOSE));
+		tables.nibble_lo[lo] |= tables.nibble_hi[hi];
 	}
 
-	RJD_RESULT_PROMOTE(advance_token(stream));
-	const struct token* text_begin = stream->tokens + stream->cursor;
-	const struct token* text_end = text_begin;
+	TOKENIZER_TABLES = tables;
 
-	rjd_strbuf_append(out, "<a href=\"");
-	while (text_end->type != TOKEN_TYPE_PAREN_CLOSE)
-	{
-		rjd_strbuf_appendl(out, text_end->text, text_end->length);
-		RJD_RESULT_PROMOTE(advance_token(stream));
-		text_end = stream->tokens + stream->cursor;
-	}
-	rjd_strbuf_append(out, "\"");
-	if (open_new_tab) {
-		rjd_strbuf_append(out, " target=\"_blank\"");
+	if (isa == TEXT_SCAN_ISA_DETECT) {
+		isa = TEXT_SCAN_ISA_SCALAR;
+	#if GEN_TOKENIZER_X64
+		isa = cpu_supports_avx2() ? TEXT_SCAN_ISA_AVX2 : TEXT_SCAN_ISA_SSE2;
+	#elif GEN_TOKENIZER_NEON
+		isa = TEXT_SCAN_ISA_NEON;
+	#endif
 	}
-	rjd_strbuf_append(out, ">");
-	rjd_strbuf_appendl(out, link_text_start->text, (uint32_t)(link_text_end->text - link_text_start->text));
-	rjd_strbuf_append(out, "</a>");
 
-	return RJD_RESULT_OK();
+	find_token_symbol = find_token_symbol_scalar;
+	find_html_special = find_html_special_scalar;
+	switch (isa)
+	{
+	#if GEN_TOKENIZER_X64
+		case TEXT_SCAN_ISA_SSE2:
+			find_token_symbol = find_token_symbol_sse2;
+			find_html_special = find_html_special_sse2;
+			break;
+		case TEXT_SCAN_ISA_AVX2:
+			find_token_symbol = find_token_symbol_avx2;
+			find_html_special = find_html_special_avx2;
+			break;
+	#endif
+	#if GEN_TOKENIZER_NEON
+		case TEXT_SCAN_ISA_NEON:
+			find_token_symbol = find_token_symbol_neon;
+			find_html_special = find_html_special_neon;
+			break;
+	#endif
+		default: break;
+	}
 }
 
-uint32_t find_html_tag_length(const struct token* t)
+// The number of tokens tokenize() splits the text into. Prose runs hundreds of bytes between
+// symbols, so sizing the token array with this instead of a token per byte keeps the page arena
+// close to what the page uses.
+GEN_INTERNAL uint32_t tokenize_count(const char* text, size_t length)
 {
-	RJD_ASSERT(t->type == TOKEN_TYPE_TEXT);
+	RJD_ASSERTMSG(find_token_symbol != NULL, "Call text_scan_init() before tokenize_count()");
 
-	for (uint32_t i = 0; i < t->length; ++i) {
-		if (!isspace((int)t->text[i])) {
-			return i;
-		}
+	uint32_t count = 0;
+	const char* end = text + length;
+	for (const char* next = text; next < end; ++count) {
+		next = TOKEN_CLASSES[(uint8_t)*next] == TOKEN_TYPE_TEXT ? find_token_symbol(next + 1, end) : next + 1;
 	}
-	return t->length;
+	return count;
 }
 
-struct rjd_result parse_html(struct rjd_strbuf* out, struct token_stream* stream)
+// Returns an rjd_array of tokens pointing into text. Symbol tokens are always 1 byte, and text
+// tokens are runs of everything in between. token_count is from tokenize_count().
+GEN_INTERNAL struct token* tokenize(const char* text, size_t length, uint32_t token_count, struct rjd_mem_allocator* alloc)
 {
-	const struct token* t = stream->tokens + stream->cursor;
-	RJD_ASSERT(t->type == TOKEN_TYPE_ANGLE_BRACKET_OPEN);
-
-	append_indent(out, stream);
-	rjd_strbuf_appendl(out, t->text, t->length);
-
-	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_TEXT));
-	t = stream->tokens + stream->cursor;
-	const struct token* html_tag = t;
-	const uint32_t html_tag_length = find_html_tag_length(t);
+	RJD_ASSERTMSG(find_token_symbol != NULL, "Call text_scan_init() before tokenize()");
 
-	rjd_strbuf_appendl(out, t->text, t->length);
-	++stream->indent;
+	// One more for the empty token at the end, and the capacity never needs to grow
+	struct token* tokens = rjd_array_alloc(struct token, token_count + 1, alloc);
 
-	int32_t tag_count = 1;
-	while (tag_count > 0)
+	const char* end = text + length;
+	for (const char* next = text; next < end; )
 	{
-		RJD_RESULT_PROMOTE(advance_token(stream));
-		t = stream->tokens + stream->cursor;
+		struct token t = {
+			.type = TOKEN_CLASSES[(uint8_t)*next], 
+			.text = next, 
+			.length = 1
+		};
 
-		const struct token* next = NULL;
-		const struct token* next2 = NULL;
-		if (stream->cursor + 2 < rjd_array_count(stream->tokens)) {
-			next = stream->tokens + stream->cursor + 1;
-			next2 = stream->tokens + stream->cursor + 2;
+		if (t.type == TOKEN_TYPE_TEXT) {
+			next = find_token_symbol(next + 1, end);
+			t.length = (uint32_t)(next - t.text);
+		} else {
+			++next;
 		}
 
-		if (t->type == TOKEN_TYPE_ANGLE_BRACKET_OPEN &&
-			next && next->type == TOKEN_TYPE_TEXT)
-		{
-			uint32_t next_length = find_html_tag_length(next);
-			uint32_t length = rjd_math_min_u32(html_tag_length, next_length);
-
-			if (!strncmp(html_tag->text, next->text, length)) {
-				++tag_count;
-				++stream->indent;
-			}
-		}
+		rjd_array_push(tokens, t);
+	}
 
-		if (t->type == TOKEN_TYPE_ANGLE_BRACKET_OPEN &&
-			next && next->type == TOKEN_TYPE_SLASH_FORWARD &&
-			next2 && next2->type == TOKEN_TYPE_TEXT)
-		{
-			uint32_t next2_length = find_html_tag_length(next2);
-			uint32_t length = rjd_math_min_u32(html_tag->length, next2_length);
+	RJD_ASSERT(rjd_array_count(tokens) == token_count);
 
-			if (!strncmp(html_tag->text, next2->text, length)) {
-				--tag_count;
-				--stream->indent;
+	// Some parsers look at the token after the last one when a block ends the file (e.g. a quote),
+	// so leave an empty token there instead of whatever the arena held from the previous page.
+	tokens[rjd_array_count(tokens)] = (struct token){0};
 
-				if (tag_count == 0) {
-					// a bit of a hack, but we didn't know this would be 
-					// the end tag when we were adding the previous indent
-					if (rjd_strbuf_str(out)[out->length - 1] == '\t') {
-						out->length -= 1;
-					}
-				}
-			}
-		}
+	return tokens;
+}
 
-		rjd_strbuf_appendl(out, t->text, t->length);
+// Code blocks are highlighted when the page is built, so pages don't need to run highlight.js. Each
+// language is a table of words and a few lexing rules, and the spans use the highlight.js class
+// names so the existing theme (monokai.css) styles them.
+enum highlight_class
+{
+	HIGHLIGHT_CLASS_NONE,
+	HIGHLIGHT_CLASS_KEYWORD,
+	HIGHLIGHT_CLASS_LITERAL,
+	HIGHLIGHT_CLASS_BUILT_IN,
+	HIGHLIGHT_CLASS_TYPE,
+	HIGHLIGHT_CLASS_STRING,
+	HIGHLIGHT_CLASS_NUMBER,
+	HIGHLIGHT_CLASS_COMMENT,
+	HIGHLIGHT_CLASS_META,
+	HIGHLIGHT_CLASS_ATTR,
+	HIGHLIGHT_CLASS_BULLET,
+	HIGHLIGHT_CLASS_VARIABLE,
+	HIGHLIGHT_CLASS_COUNT,
+};
 
-		if (t->type == TOKEN_TYPE_NEWLINE) {
-			append_indent(out, stream);
-		}
-	}
+GEN_INTERNAL const char* HIGHLIGHT_CLASS_SPANS[] =
+{
+	NULL,
+	"<span class=\"hljs-keyword\">",
+	"<span class=\"hljs-literal\">",
+	"<span class=\"hljs-built_in\">",
+	"<span class=\"hljs-type\">",
+	"<span class=\"hljs-string\">",
+	"<span class=\"hljs-number\">",
+	"<span class=\"hljs-comment\">",
+	"<span class=\"hljs-meta\">",
+	"<span class=\"hljs-attr\">",
+	"<span class=\"hljs-bullet\">",
+	"<span class=\"hljs-variable\">",
+};
+RJD_STATIC_ASSERT(rjd_countof(HIGHLIGHT_CLASS_SPANS) == HIGHLIGHT_CLASS_COUNT);
 
-	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SLASH_FORWARD));
-	t = stream->tokens + stream->cursor;
-	rjd_strbuf_appendl(out, t->text, t->length);
+struct highlight_word
+{
+	const char* word;
+	enum highlight_class class;
+};
 
-	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_TEXT));
-	t = stream->tokens + stream->cursor;
-	rjd_strbuf_appendl(out, t->text, t->length);
+// Word tables must be sorted by strcmp() for highlight_find_word()
+GEN_INTERNAL const struct highlight_word HIGHLIGHT_WORDS_C[] =
+{
+	{ "NULL", HIGHLIGHT_CLASS_LITERAL },
+	{ "_Alignas", HIGHLIGHT_CLASS_KEYWORD },
+	{ "_Alignof", HIGHLIGHT_CLASS_KEYWORD },
+	{ "_Bool", HIGHLIGHT_CLASS_KEYWORD },
+	{ "_Static_assert", HIGHLIGHT_CLASS_KEYWORD },
+	{ "_Thread_local", HIGHLIGHT_CLASS_KEYWORD },
+	{ "auto", HIGHLIGHT_CLASS_KEYWORD },
+	{ "bool", HIGHLIGHT_CLASS_KEYWORD },
+	{ "break", HIGHLIGHT_CLASS_KEYWORD },
+	{ "calloc", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "case", HIGHLIGHT_CLASS_KEYWORD },
+	{ "char", HIGHLIGHT_CLASS_KEYWORD },
+	{ "const", HIGHLIGHT_CLASS_KEYWORD },
+	{ "continue", HIGHLIGHT_CLASS_KEYWORD },
+	{ "default", HIGHLIGHT_CLASS_KEYWORD },
+	{ "do", HIGHLIGHT_CLASS_KEYWORD },
+	{ "double", HIGHLIGHT_CLASS_KEYWORD },
+	{ "else", HIGHLIGHT_CLASS_KEYWORD },
+	{ "enum", HIGHLIGHT_CLASS_KEYWORD },
+	{ "exit", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "extern", HIGHLIGHT_CLASS_KEYWORD },
+	{ "false", HIGHLIGHT_CLASS_LITERAL },
+	{ "float", HIGHLIGHT_CLASS_KEYWORD },
+	{ "for", HIGHLIGHT_CLASS_KEYWORD },
+	{ "fprintf", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "free", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "goto", HIGHLIGHT_CLASS_KEYWORD },
+	{ "if", HIGHLIGHT_CLASS_KEYWORD },
+	{ "inline", HIGHLIGHT_CLASS_KEYWORD },
+	{ "int", HIGHLIGHT_CLASS_KEYWORD },
+	{ "int16_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "int32_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "int64_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "int8_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "long", HIGHLIGHT_CLASS_KEYWORD },
+	{ "malloc", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "memcmp", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "memcpy", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "memset", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "printf", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "realloc", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "register", HIGHLIGHT_CLASS_KEYWORD },
+	{ "restrict", HIGHLIGHT_CLASS_KEYWORD },
+	{ "return", HIGHLIGHT_CLASS_KEYWORD },
+	{ "short", HIGHLIGHT_CLASS_KEYWORD },
+	{ "signed", HIGHLIGHT_CLASS_KEYWORD },
+	{ "size_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "sizeof", HIGHLIGHT_CLASS_KEYWORD },
+	{ "snprintf", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "static", HIGHLIGHT_CLASS_KEYWORD },
+	{ "strcmp", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "strlen", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "strncmp", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "struct", HIGHLIGHT_CLASS_KEYWORD },
+	{ "switch", HIGHLIGHT_CLASS_KEYWORD },
+	{ "true", HIGHLIGHT_CLASS_LITERAL },
+	{ "typedef", HIGHLIGHT_CLASS_KEYWORD },
+	{ "uint16_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "uint32_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "uint64_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "uint8_t", HIGHLIGHT_CLASS_KEYWORD },
+	{ "union", HIGHLIGHT_CLASS_KEYWORD },
+	{ "unsigned", HIGHLIGHT_CLASS_KEYWORD },
+	{ "void", HIGHLIGHT_CLASS_KEYWORD },
+	{ "volatile", HIGHLIGHT_CLASS_KEYWORD },
+	{ "while", HIGHLIGHT_CLASS_KEYWORD },
+};
 
-	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_ANGLE_BRACKET_CLOSE));
-	t = stream->tokens + stream->cursor;
-	rjd_strbuf_appendl(out, t->text, t->length);
+// Only the words C++ adds to C
+GEN_INTERNAL const struct highlight_word HIGHLIGHT_WORDS_CPP[] =
+{
+	{ "alignas", HIGHLIGHT_CLASS_KEYWORD },
+	{ "alignof", HIGHLIGHT_CLASS_KEYWORD },
+	{ "catch", HIGHLIGHT_CLASS_KEYWORD },
+	{ "cerr", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "class", HIGHLIGHT_CLASS_KEYWORD },
+	{ "const_cast", HIGHLIGHT_CLASS_KEYWORD },
+	{ "constexpr", HIGHLIGHT_CLASS_KEYWORD },
+	{ "cout", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "decltype", HIGHLIGHT_CLASS_KEYWORD },
+	{ "delete", HIGHLIGHT_CLASS_KEYWORD },
+	{ "dynamic_cast", HIGHLIGHT_CLASS_KEYWORD },
+	{ "endl", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "explicit", HIGHLIGHT_CLASS_KEYWORD },
+	{ "final", HIGHLIGHT_CLASS_KEYWORD },
+	{ "friend", HIGHLIGHT_CLASS_KEYWORD },
+	{ "mutable", HIGHLIGHT_CLASS_KEYWORD },
+	{ "namespace", HIGHLIGHT_CLASS_KEYWORD },
+	{ "new", HIGHLIGHT_CLASS_KEYWORD },
+	{ "noexcept", HIGHLIGHT_CLASS_KEYWORD },
+	{ "nullptr", HIGHLIGHT_CLASS_LITERAL },
+	{ "operator", HIGHLIGHT_CLASS_KEYWORD },
+	{ "override", HIGHLIGHT_CLASS_KEYWORD },
+	{ "private", HIGHLIGHT_CLASS_KEYWORD },
+	{ "protected", HIGHLIGHT_CLASS_KEYWORD },
+	{ "public", HIGHLIGHT_CLASS_KEYWORD },
+	{ "reinterpret_cast", HIGHLIGHT_CLASS_KEYWORD },
+	{ "shared_ptr", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "static_assert", HIGHLIGHT_CLASS_KEYWORD },
+	{ "static_cast", HIGHLIGHT_CLASS_KEYWORD },
+	{ "std", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "string", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "template", HIGHLIGHT_CLASS_KEYWORD },
+	{ "this", HIGHLIGHT_CLASS_KEYWORD },
+	{ "thread_local", HIGHLIGHT_CLASS_KEYWORD },
+	{ "throw", HIGHLIGHT_CLASS_KEYWORD },
+	{ "try", HIGHLIGHT_CLASS_KEYWORD },
+	{ "typename", HIGHLIGHT_CLASS_KEYWORD },
+	{ "unique_ptr", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "using", HIGHLIGHT_CLASS_KEYWORD },
+	{ "vector", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "virtual", HIGHLIGHT_CLASS_KEYWORD },
+};
 
-	rjd_strbuf_append(out, "\n");
+GEN_INTERNAL const struct highlight_word HIGHLIGHT_WORDS_ZIG[] =
+{
+	{ "addrspace", HIGHLIGHT_CLASS_KEYWORD },
+	{ "align", HIGHLIGHT_CLASS_KEYWORD },
+	{ "allowzero", HIGHLIGHT_CLASS_KEYWORD },
+	{ "and", HIGHLIGHT_CLASS_KEYWORD },
+	{ "anyerror", HIGHLIGHT_CLASS_TYPE },
+	{ "anyframe", HIGHLIGHT_CLASS_KEYWORD },
+	{ "anyopaque", HIGHLIGHT_CLASS_TYPE },
+	{ "anytype", HIGHLIGHT_CLASS_KEYWORD },
+	{ "asm", HIGHLIGHT_CLASS_KEYWORD },
+	{ "bool", HIGHLIGHT_CLASS_TYPE },
+	{ "break", HIGHLIGHT_CLASS_KEYWORD },
+	{ "c_int", HIGHLIGHT_CLASS_TYPE },
+	{ "callconv", HIGHLIGHT_CLASS_KEYWORD },
+	{ "catch", HIGHLIGHT_CLASS_KEYWORD },
+	{ "comptime", HIGHLIGHT_CLASS_KEYWORD },
+	{ "comptime_float", HIGHLIGHT_CLASS_TYPE },
+	{ "comptime_int", HIGHLIGHT_CLASS_TYPE },
+	{ "const", HIGHLIGHT_CLASS_KEYWORD },
+	{ "continue", HIGHLIGHT_CLASS_KEYWORD },
+	{ "defer", HIGHLIGHT_CLASS_KEYWORD },
+	{ "else", HIGHLIGHT_CLASS_KEYWORD },
+	{ "enum", HIGHLIGHT_CLASS_KEYWORD },
+	{ "errdefer", HIGHLIGHT_CLASS_KEYWORD },
+	{ "error", HIGHLIGHT_CLASS_KEYWORD },
+	{ "export", HIGHLIGHT_CLASS_KEYWORD },
+	{ "extern", HIGHLIGHT_CLASS_KEYWORD },
+	{ "f16", HIGHLIGHT_CLASS_TYPE },
+	{ "f32", HIGHLIGHT_CLASS_TYPE },
+	{ "f64", HIGHLIGHT_CLASS_TYPE },
+	{ "false", HIGHLIGHT_CLASS_LITERAL },
+	{ "fn", HIGHLIGHT_CLASS_KEYWORD },
+	{ "for", HIGHLIGHT_CLASS_KEYWORD },
+	{ "i16", HIGHLIGHT_CLASS_TYPE },
+	{ "i32", HIGHLIGHT_CLASS_TYPE },
+	{ "i64", HIGHLIGHT_CLASS_TYPE },
+	{ "i8", HIGHLIGHT_CLASS_TYPE },
+	{ "if", HIGHLIGHT_CLASS_KEYWORD },
+	{ "inline", HIGHLIGHT_CLASS_KEYWORD },
+	{ "isize", HIGHLIGHT_CLASS_TYPE },
+	{ "noalias", HIGHLIGHT_CLASS_KEYWORD },
+	{ "noinline", HIGHLIGHT_CLASS_KEYWORD },
+	{ "noreturn", HIGHLIGHT_CLASS_TYPE },
+	{ "nosuspend", HIGHLIGHT_CLASS_KEYWORD },
+	{ "null", HIGHLIGHT_CLASS_LITERAL },
+	{ "opaque", HIGHLIGHT_CLASS_KEYWORD },
+	{ "or", HIGHLIGHT_CLASS_KEYWORD },
+	{ "orelse", HIGHLIGHT_CLASS_KEYWORD },
+	{ "packed", HIGHLIGHT_CLASS_KEYWORD },
+	{ "pub", HIGHLIGHT_CLASS_KEYWORD },
+	{ "return", HIGHLIGHT_CLASS_KEYWORD },
+	{ "struct", HIGHLIGHT_CLASS_KEYWORD },
+	{ "switch", HIGHLIGHT_CLASS_KEYWORD },
+	{ "test", HIGHLIGHT_CLASS_KEYWORD },
+	{ "threadlocal", HIGHLIGHT_CLASS_KEYWORD },
+	{ "true", HIGHLIGHT_CLASS_LITERAL },
+	{ "try", HIGHLIGHT_CLASS_KEYWORD },
+	{ "type", HIGHLIGHT_CLASS_TYPE },
+	{ "u16", HIGHLIGHT_CLASS_TYPE },
+	{ "u32", HIGHLIGHT_CLASS_TYPE },
+	{ "u64", HIGHLIGHT_CLASS_TYPE },
+	{ "u8", HIGHLIGHT_CLASS_TYPE },
+	{ "undefined", HIGHLIGHT_CLASS_LITERAL },
+	{ "union", HIGHLIGHT_CLASS_KEYWORD },
+	{ "unreachable", HIGHLIGHT_CLASS_KEYWORD },
+	{ "usingnamespace", HIGHLIGHT_CLASS_KEYWORD },
+	{ "usize", HIGHLIGHT_CLASS_TYPE },
+	{ "var", HIGHLIGHT_CLASS_KEYWORD },
+	{ "void", HIGHLIGHT_CLASS_TYPE },
+	{ "volatile", HIGHLIGHT_CLASS_KEYWORD },
+	{ "while", HIGHLIGHT_CLASS_KEYWORD },
+};
 
-	advance_token(stream);
+GEN_INTERNAL const struct highlight_word HIGHLIGHT_WORDS_YAML[] =
+{
+	{ "false", HIGHLIGHT_CLASS_LITERAL },
+	{ "no", HIGHLIGHT_CLASS_LITERAL },
+	{ "null", HIGHLIGHT_CLASS_LITERAL },
+	{ "true", HIGHLIGHT_CLASS_LITERAL },
+	{ "yes", HIGHLIGHT_CLASS_LITERAL },
+};
 
-	return RJD_RESULT_OK();
-}
+GEN_INTERNAL const struct highlight_word HIGHLIGHT_WORDS_SHELL[] =
+{
+	{ "alias", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "case", HIGHLIGHT_CLASS_KEYWORD },
+	{ "cd", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "do", HIGHLIGHT_CLASS_KEYWORD },
+	{ "done", HIGHLIGHT_CLASS_KEYWORD },
+	{ "echo", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "elif", HIGHLIGHT_CLASS_KEYWORD },
+	{ "else", HIGHLIGHT_CLASS_KEYWORD },
+	{ "esac", HIGHLIGHT_CLASS_KEYWORD },
+	{ "eval", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "exec", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "exit", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "export", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "fi", HIGHLIGHT_CLASS_KEYWORD },
+	{ "for", HIGHLIGHT_CLASS_KEYWORD },
+	{ "function", HIGHLIGHT_CLASS_KEYWORD },
+	{ "if", HIGHLIGHT_CLASS_KEYWORD },
+	{ "in", HIGHLIGHT_CLASS_KEYWORD },
+	{ "local", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "printf", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "pwd", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "read", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "return", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "set", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "shift", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "source", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "then", HIGHLIGHT_CLASS_KEYWORD },
+	{ "time", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "unset", HIGHLIGHT_CLASS_BUILT_IN },
+	{ "until", HIGHLIGHT_CLASS_KEYWORD },
+	{ "while", HIGHLIGHT_CLASS_KEYWORD },
+};
 
-struct rjd_result parse_quote(struct rjd_strbuf* out, struct token_stream* stream)
+struct highlight_words
 {
-	const struct token* t = stream->tokens + stream->cursor;
-	RJD_ASSERT(t->type == TOKEN_TYPE_ANGLE_BRACKET_CLOSE);
+	const struct highlight_word* words;
+	uint32_t count;
+};
 
-	append_indent(out, stream);
-	rjd_strbuf_append(out, "<p class=\"quote\">");
+#define HIGHLIGHT_WORDS(table) { table, rjd_countof(table) }
 
-	while (t->type == TOKEN_TYPE_ANGLE_BRACKET_CLOSE)
-	{
-		advance_token(stream);
-		RJD_RESULT_PROMOTE(parse_text(out, stream));
+struct highlight_language
+{
+	const char* names[5]; // names a code block can be tagged with, the first is used for its class
+	struct highlight_words words[2]; // searched in order
+	const char* line_comment;
+	const char* block_comment_begin;
+	const char* block_comment_end;
+	const char* quotes;
+	char meta_prefix; // a line starting with this is all meta, e.g. the C preprocessor
+	char built_in_prefix; // starts a built-in name, e.g. zig's @import
+	char variable_prefix;
+	bool prompts; // lines starting with "> " or "$ " are commands typed into a shell
+	bool keys; // lines can start with a "key:" or a "- " list item
+};
 
-		if (peek_token(stream, TOKEN_TYPE_NEWLINE)) {
+GEN_INTERNAL const struct highlight_language HIGHLIGHT_LANGUAGES[] =
+{
+	{
+		.names = { "c", "h" },
+		.words = { HIGHLIGHT_WORDS(HIGHLIGHT_WORDS_C) },
+		.line_comment = "//",
+		.block_comment_begin = "/*",
+		.block_comment_end = "*/",
+		.quotes = "\"'",
+		.meta_prefix = '#',
+	},
+	{
+		.names = { "cpp", "c++", "cc", "hpp", "cxx" },
+		.words = { HIGHLIGHT_WORDS(HIGHLIGHT_WORDS_C), HIGHLIGHT_WORDS(HIGHLIGHT_WORDS_CPP) },
+		.line_comment = "//",
+		.block_comment_begin = "/*",
+		.block_comment_end = "*/",
+		.quotes = "\"'",
+		.meta_prefix = '#',
+	},
+	{
+		.names = { "zig", "zon" },
+		.words = { HIGHLIGHT_WORDS(HIGHLIGHT_WORDS_ZIG) },
+		.line_comment = "//",
+		.quotes = "\"'",
+		.built_in_prefix = '@',
+	},
+	{
+		.names = { "yaml", "yml" },
+		.words = { HIGHLIGHT_WORDS(HIGHLIGHT_WORDS_YAML) },
+		.line_comment = "#",
+		.quotes = "\"'",
+		.keys = true,
+	},
+	{
+		.names = { "shell", "sh", "bash", "console", "zsh" },
+		.words = { HIGHLIGHT_WORDS(HIGHLIGHT_WORDS_SHELL) },
+		.line_comment = "#",
+		.quotes = "\"'",
+		.variable_prefix = '$',
+		.prompts = true,
+	},
+};
+
+// Code blocks store the language + 1, so 0 is a block without a known language
+#define HIGHLIGHT_LANGUAGE_NONE 0
+
+GEN_INTERNAL uint16_t highlight_find_language(const char* name, uint32_t length)
+{
+	while (length > 0 && isspace((unsigned char)name[length - 1])) {
+		--length;
+	}
+
+	for (uint32_t i = 0; i < rjd_countof(HIGHLIGHT_LANGUAGES); ++i) {
+		const struct highlight_language* language = HIGHLIGHT_LANGUAGES + i;
+		for (uint32_t n = 0; n < rjd_countof(language->names) && language->names[n]; ++n) {
+			if (strlen(language->names[n]) == length && strncmp(language->names[n], name, length) == 0) {
+				return (uint16_t)(i + 1);
+			}
+		}
+	}
+	return HIGHLIGHT_LANGUAGE_NONE;
+}
+
+GEN_INTERNAL enum highlight_class highlight_find_word(const struct highlight_language* language, const char* word, uint32_t length)
+{
+	for (uint32_t w = 0; w < rjd_countof(language->words); ++w) {
+		const struct highlight_words* words = language->words + w;
+		uint32_t low = 0;
+		uint32_t high = words->count;
+		while (low < high) {
+			const uint32_t mid = (low + high) / 2;
+			const char* candidate = words->words[mid].word;
+			int order = strncmp(candidate, word, length);
+			if (order == 0 && candidate[length] != '\0') {
+				order = 1;
+			}
+			if (order == 0) {
+				return words->words[mid].class;
+			}
+			if (order < 0) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+	}
+	return HIGHLIGHT_CLASS_NONE;
+}
+
+GEN_INTERNAL bool highlight_is_word_char(char c)
+{
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+GEN_INTERNAL bool highlight_starts_with(const char* text, uint32_t length, uint32_t i, const char* prefix)
+{
+	if (prefix == NULL || text[i] != prefix[0]) {
+		return false;
+	}
+	const uint32_t prefix_length = (uint32_t)strlen(prefix);
+	return length - i >= prefix_length && memcmp(text + i, prefix, prefix_length) == 0;
+}
+
+GEN_INTERNAL uint32_t highlight_line_end(const char* text, uint32_t length, uint32_t i)
+{
+	while (i < length && text[i] != '\n') {
+		++i;
+	}
+	return i;
+}
+
+// Finds the end of the span starting at i and what it should be highlighted as. line_start is true if
+// only whitespace comes before i on its line.
+GEN_INTERNAL uint32_t highlight_span(const struct highlight_language* language, const char* text, uint32_t length, uint32_t i, bool line_start, enum highlight_class* out_class)
+{
+	const char c = text[i];
+	const char prev = i > 0 ? text[i - 1] : '\n';
+	*out_class = HIGHLIGHT_CLASS_NONE;
+
+	if (line_start) {
+		if (language->meta_prefix && c == language->meta_prefix) {
+			// continues onto the next line after a trailing backslash, like a multiline #define
+			uint32_t end = highlight_line_end(text, length, i);
+			while (end < length && (text[end - 1] == '\\' || (text[end - 1] == '\r' && text[end - 2] == '\\'))) {
+				end = highlight_line_end(text, length, end + 1);
+			}
+			*out_class = HIGHLIGHT_CLASS_META;
+			return end;
+		}
+		if (language->prompts && (c == '>' || c == '$') && i + 1 < length && text[i + 1] == ' ') {
+			*out_class = HIGHLIGHT_CLASS_META;
+			return i + 1;
+		}
+		if (language->keys) {
+			if (c == '-' && i + 1 < length && text[i + 1] == ' ') {
+				*out_class = HIGHLIGHT_CLASS_BULLET;
+				return i + 1;
+			}
+			uint32_t end = i;
+			while (end < length && !strchr(":#\"' \t\r\n", text[end])) {
+				++end;
+			}
+			if (end > i && end < length && text[end] == ':' && (end + 1 == length || isspace((unsigned char)text[end + 1]))) {
+				*out_class = HIGHLIGHT_CLASS_ATTR;
+				return end;
+			}
+		}
+	}
+
+	// shell comments have to start a word, since # also shows up in arguments
+	if (highlight_starts_with(text, length, i, language->line_comment) && (language->line_comment[0] != '#' || isspace((unsigned char)prev))) {
+		*out_class = HIGHLIGHT_CLASS_COMMENT;
+		return highlight_line_end(text, length, i);
+	}
+
+	if (highlight_starts_with(text, length, i, language->block_comment_begin)) {
+		uint32_t end = i + (uint32_t)strlen(language->block_comment_begin);
+		while (end < length && !highlight_starts_with(text, length, end, language->block_comment_end)) {
+			++end;
+		}
+		*out_class = HIGHLIGHT_CLASS_COMMENT;
+		return rjd_math_min_u32(end + (uint32_t)strlen(language->block_comment_end), length);
+	}
+
+	// a quote in the middle of a word is an apostrophe
+	if (c != '\0' && strchr(language->quotes, c) && !highlight_is_word_char(prev)) {
+		uint32_t end = i + 1;
+		while (end < length && text[end] != c && text[end] != '\n') {
+			end += (text[end] == '\\' && end + 1 < length) ? 2 : 1;
+		}
+		*out_class = HIGHLIGHT_CLASS_STRING;
+		return (end < length && text[end] == c) ? end + 1 : end;
+	}
+
+	if (language->variable_prefix && c == language->variable_prefix && i + 1 < length) {
+		uint32_t end = i + 1;
+		if (text[end] == '{') {
+			while (end < length && text[end] != '}' && text[end] != '\n') {
+				++end;
+			}
+			end = rjd_math_min_u32(end + 1, length);
+		} else {
+			while (end < length && highlight_is_word_char(text[end])) {
+				++end;
+			}
+		}
+		if (end > i + 1) {
+			*out_class = HIGHLIGHT_CLASS_VARIABLE;
+			return end;
+		}
+	}
+
+	if (language->built_in_prefix && c == language->built_in_prefix && i + 1 < length && (isalpha((unsigned char)text[i + 1]) || text[i + 1] == '_')) {
+		uint32_t end = i + 1;
+		while (end < length && highlight_is_word_char(text[end])) {
+			++end;
+		}
+		*out_class = HIGHLIGHT_CLASS_BUILT_IN;
+		return end;
+	}
+
+	if (highlight_is_word_char(c)) {
+		uint32_t end = i + 1;
+		while (end < length && (highlight_is_word_char(text[end]) || (isdigit((unsigned char)c) && text[end] == '.' && end + 1 < length && isdigit((unsigned char)text[end + 1])))) {
+			++end;
+		}
+
+		if (isdigit((unsigned char)c)) {
+			*out_class = HIGHLIGHT_CLASS_NUMBER;
+		} else if (prev != '.' && prev != '/' && prev != '-') {
+			// members and path or flag pieces aren't keywords even if they're spelled like one
+			*out_class = highlight_find_word(language, text + i, end - i);
+		}
+		return end;
+	}
+
+	return i + 1;
+}
+
+GEN_INTERNAL void append_highlighted(struct rjd_strbuf* out, const struct highlight_language* language, const char* text, uint32_t length)
+{
+	uint32_t plain = 0; // start of the text that hasn't been output yet
+	bool line_start = true;
+
+	uint32_t i = 0;
+	while (i < length) {
+		enum highlight_class class = HIGHLIGHT_CLASS_NONE;
+		const uint32_t end = highlight_span(language, text, length, i, line_start, &class);
+
+		if (class != HIGHLIGHT_CLASS_NONE) {
+			append_html_escaped(out, text + plain, i - plain);
+			rjd_strbuf_appendl(out, HIGHLIGHT_CLASS_SPANS[class], (uint32_t)strlen(HIGHLIGHT_CLASS_SPANS[class]));
+			append_html_escaped(out, text + i, end - i);
+			rjd_strbuf_appendl(out, "</span>", 7);
+			plain = end;
+		}
+
+		// a yaml list item can start with a key, so the bullet doesn't end the start of the line
+		const char last = text[end - 1];
+		if (last == '\n') {
+			line_start = true;
+		} else if (last != ' ' && last != '\t' && last != '\r' && class != HIGHLIGHT_CLASS_BULLET) {
+			line_start = false;
+		}
+		i = end;
+	}
+
+	append_html_escaped(out, text + plain, length - plain);
+}
+
+// Markdown is parsed into a document before any HTML is written, so a page can be rendered more
+// than once (or into something other than HTML) without parsing it again. Nodes are stored in
+// document order as a struct of arrays. A node's children directly follow it, up to ends[node].
+enum doc_node_type
+{
+	// blocks
+	DOC_NODE_PARAGRAPH, // value is 1 if the paragraph is wrapped in <p>
+	DOC_NODE_HEADER, // value is the header level
+	DOC_NODE_LIST,
+	DOC_NODE_LIST_ITEM,
+	DOC_NODE_QUOTE,
+	DOC_NODE_HTML,
+	DOC_NODE_CODE_BLOCK, // value is the highlight language
+
+	// inlines
+	DOC_NODE_TEXT, // escaped on output
+	DOC_NODE_RAW, // html from the markdown, output as-is
+	DOC_NODE_HTML_NEWLINE, // a newline in an html block and the indent that follows it
+	DOC_NODE_QUOTE_BREAK, // between the lines of a quote
+	DOC_NODE_CODE_SPAN,
+	DOC_NODE_EMPHASIS, // value is the enum emphasis
+	DOC_NODE_LINK, // text is the href, value is 1 to open in a new tab. Children are the link text.
+};
+
+struct document
+{
+	// rjd_arrays, all the same length
+	uint8_t* types;
+	uint16_t* indents; // blocks and html newlines
+	uint16_t* values;
+	uint32_t* ends; // one past the node's last descendant
+	const char** texts; // text, raw, and link nodes point into the markdown source
+	uint32_t* lengths;
+
+	uint32_t* open_nodes; // rjd_array of nodes that haven't been closed yet, innermost last
+
+	const struct token* title; // the first header's text, or NULL
+	uint32_t mergeable_node; // the last node if it's text that can still be extended
+};
+
+// The most nodes parsing the tokens can make. Every node starts at a different token, except a block
+// and its first child can start at the same one.
+GEN_INTERNAL uint32_t document_capacity(uint32_t token_count)
+{
+	return token_count * 2 + 1;
+}
+
+GEN_INTERNAL size_t document_memory_required(uint32_t capacity)
+{
+	const size_t node_size = sizeof(uint8_t) + sizeof(uint16_t) * 2 + sizeof(uint32_t) * 3 + sizeof(const char*);
+	const size_t array_overhead = 7 * 64; // rjd_array headers and alignment
+	return (size_t)capacity * node_size + array_overhead;
+}
+
+GEN_INTERNAL struct document document_init(uint32_t capacity, struct rjd_mem_allocator* alloc)
+{
+	struct document doc = {
+		.types = rjd_array_alloc(uint8_t, capacity, alloc),
+		.indents = rjd_array_alloc(uint16_t, capacity, alloc),
+		.values = rjd_array_alloc(uint16_t, capacity, alloc),
+		.ends = rjd_array_alloc(uint32_t, capacity, alloc),
+		.texts = rjd_array_alloc(const char*, capacity, alloc),
+		.lengths = rjd_array_alloc(uint32_t, capacity, alloc),
+		.open_nodes = rjd_array_alloc(uint32_t, capacity, alloc),
+		.title = NULL,
+		.mergeable_node = UINT32_MAX,
+	};
+	return doc;
+}
+
+GEN_INTERNAL uint32_t document_count(const struct document* doc)
+{
+	return rjd_array_count(doc->types);
+}
+
+GEN_INTERNAL uint32_t document_push(struct document* doc, enum doc_node_type type, int32_t indent, uint16_t value, const char* text, uint32_t length)
+{
+	const uint32_t node = document_count(doc);
+	RJD_ASSERTMSG(node < rjd_array_capacity(doc->types), "document_capacity() is too small");
+
+	rjd_array_push(doc->types, (uint8_t)type);
+	rjd_array_push(doc->indents, (uint16_t)rjd_math_max_i32(indent, 0));
+	rjd_array_push(doc->values, value);
+	rjd_array_push(doc->ends, node + 1);
+	rjd_array_push(doc->texts, text);
+	rjd_array_push(doc->lengths, length);
+	doc->mergeable_node = UINT32_MAX;
+	return node;
+}
+
+// Starts a node whose children are pushed until document_close()
+GEN_INTERNAL uint32_t document_open(struct document* doc, enum doc_node_type type, int32_t indent, uint16_t value)
+{
+	const uint32_t node = document_push(doc, type, indent, value, NULL, 0);
+	rjd_array_push(doc->open_nodes, node);
+	return node;
+}
+
+// Also closes any children left open by a parse error, so they keep what they parsed so far
+GEN_INTERNAL void document_close(struct document* doc, uint32_t node)
+{
+	while (!rjd_array_empty(doc->open_nodes)) {
+		const uint32_t open = rjd_array_pop(doc->open_nodes);
+		doc->ends[open] = document_count(doc);
+		if (open == node) {
+			break;
+		}
+	}
+	doc->mergeable_node = UINT32_MAX;
+}
+
+// Consecutive tokens usually sit next to each other in the source, so they become one node
+GEN_INTERNAL void document_text(struct document* doc, enum doc_node_type type, const char* text, uint32_t length)
+{
+	const uint32_t last = doc->mergeable_node;
+	if (last != UINT32_MAX && doc->types[last] == type && doc->texts[last] + doc->lengths[last] == text) {
+		doc->lengths[last] += length;
+		return;
+	}
+
+	const uint32_t node = document_push(doc, type, 0, 0, text, length);
+	doc->mergeable_node = node;
+}
+
+// Drops every node from the given one onward
+GEN_INTERNAL void document_truncate(struct document* doc, uint32_t count)
+{
+	rjd_array_resize(doc->types, count);
+	rjd_array_resize(doc->indents, count);
+	rjd_array_resize(doc->values, count);
+	rjd_array_resize(doc->ends, count);
+	rjd_array_resize(doc->texts, count);
+	rjd_array_resize(doc->lengths, count);
+	uint32_t open_count = rjd_array_count(doc->open_nodes);
+	while (open_count > 0 && doc->open_nodes[open_count - 1] >= count) {
+		--open_count;
+	}
+	rjd_array_resize(doc->open_nodes, open_count);
+	doc->mergeable_node = UINT32_MAX;
+}
+
+struct token_stream
+{
+	const struct token* tokens;
+	const struct token* first_header_text;
+	uint32_t cursor;
+	int32_t indent;
+};
+
+enum paragraph_position
+{
+	PARAGRAPH_POSITION_ROOT,
+	PARAGRAPH_POSITION_INLINE,
+};
+
+// Parsing is linear in the number of tokens, whatever the markdown. The parse_* functions only
+// move the cursor forward, and stop at the end of the tokens. Nothing backtracks: a link, code span,
+// emphasis or html block that's never closed fails once it reaches the end rather than being
+// retried as text, so a run of unmatched [, _, ` or < is scanned once. Nested html only changes a
+// counter, never the call depth.
+GEN_INTERNAL struct rjd_result parse_text(struct document* doc, struct token_stream* stream);
+GEN_INTERNAL struct rjd_result parse_paragraph(struct document* doc, struct token_stream* stream);
+GEN_INTERNAL struct rjd_result parse_header(struct document* doc, struct token_stream* stream);
+GEN_INTERNAL struct rjd_result parse_list(struct document* doc, struct token_stream* stream);
+GEN_INTERNAL struct rjd_result parse_link(struct document* doc, struct token_stream* stream);
+GEN_INTERNAL struct rjd_result parse_html(struct document* doc, struct token_stream* stream);
+GEN_INTERNAL struct rjd_result parse_quote(struct document* doc, struct token_stream* stream); 
+GEN_INTERNAL struct rjd_result parse_code(struct document* doc, struct token_stream* stream, enum paragraph_position paragraph_position); 
+GEN_INTERNAL struct rjd_result parse_emphasis(struct document* doc, struct token_stream* stream);
+
+GEN_INTERNAL void append_indent(struct rjd_strbuf* out, int32_t indent)
+{
+	for (int i = 0; i < indent; ++i)
+	{
+		rjd_strbuf_appendl(out, "\t", 1);
+	}
+}
+
+GEN_INTERNAL bool stream_finished(const struct token_stream* stream)
+{
+	if (stream->cursor >= rjd_array_count(stream->tokens)) {
+		return true;
+	}
+	return false;
+}
+
+GEN_INTERNAL bool peek_token(const struct token_stream* stream, enum token_type type)
+{
+	uint32_t cursor = stream->cursor + 1;
+	if (cursor >= rjd_array_count(stream->tokens)) {
+		return true;
+	}
+	if (stream->tokens[cursor].type != type) {
+		return false;
+	}
+	return true;
+}
+
+GEN_INTERNAL struct rjd_result advance_token(struct token_stream* stream)
+{
+	++stream->cursor;
+	if (stream->cursor >= rjd_array_count(stream->tokens)) {
+		return RJD_RESULT("end of token stream");
+	}
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result consume_token(struct token_stream* stream, enum token_type type)
+{
+	// the token past the end is an empty placeholder, not something to consume
+	RJD_RESULT_PROMOTE(advance_token(stream));
+	if (stream->tokens[stream->cursor].type != type) {
+		return RJD_RESULT("consume_token: unexpected token");
+	}
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_text(struct document* doc, struct token_stream* stream)
+{
+	bool consuming = true;
+	while (consuming && !stream_finished(stream))
+	{
+		const struct token* t = stream->tokens + stream->cursor;
+		switch (t->type)
+		{
+			case TOKEN_TYPE_TEXT:
+			case TOKEN_TYPE_SLASH_FORWARD:
+			case TOKEN_TYPE_PAREN_OPEN:
+			case TOKEN_TYPE_PAREN_CLOSE:
+				document_text(doc, DOC_NODE_TEXT, t->text, t->length);
+				break;
+			case TOKEN_TYPE_SQUARE_BRACKET_OPEN:
+				RJD_RESULT_PROMOTE(parse_link(doc, stream));
+				break;
+			case TOKEN_TYPE_BACKTICK:
+				RJD_RESULT_PROMOTE(parse_code(doc, stream, PARAGRAPH_POSITION_INLINE));
+				break;
+			case TOKEN_TYPE_UNDERSCORE:
+				RJD_RESULT_PROMOTE(parse_emphasis(doc, stream));
+				break;
+			default:
+				consuming = false;
+				break;
+		}
+		advance_token(stream);
+	}
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_paragraph(struct document* doc, struct token_stream* stream)
+{
+	// Backticks count as plain text because if we've landed in this case with a backtick, we're
+	// going to make an inline code span.
+	bool is_plain_text = 
+		stream->tokens[stream->cursor].type == TOKEN_TYPE_TEXT ||
+		stream->tokens[stream->cursor].type == TOKEN_TYPE_BACKTICK ||
+		stream->tokens[stream->cursor].type == TOKEN_TYPE_UNDERSCORE;
+
+	const uint32_t node = document_open(doc, DOC_NODE_PARAGRAPH, stream->indent, is_plain_text ? 1 : 0);
+	parse_text(doc, stream);
+	document_close(doc, node);
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_header(struct document* doc, struct token_stream* stream)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+
+	RJD_ASSERT(t->type == TOKEN_TYPE_HASH);
+
+	uint32_t header_type = 0;
+
+	while (t->type == TOKEN_TYPE_HASH) {
+		++header_type;
+		RJD_RESULT_PROMOTE(advance_token(stream));
+		t = stream->tokens + stream->cursor;
+	}
+
+	if (stream->first_header_text == NULL) {
+		stream->first_header_text = t;
+	}
+
+	// html only has <h1> to <h6>, so deeper headers are all <h6>
+	const uint16_t level = (uint16_t)rjd_math_min_u32(header_type, 6);
+	const uint32_t node = document_open(doc, DOC_NODE_HEADER, stream->indent, level);
+	RJD_RESULT_PROMOTE(parse_text(doc, stream));
+	document_close(doc, node);
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_list(struct document* doc, struct token_stream* stream)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+
+	RJD_ASSERT(t->type == TOKEN_TYPE_ASTERISK);
+	const uint32_t list = document_open(doc, DOC_NODE_LIST, stream->indent, 0);
+
+	stream->indent += 1;
+
+	while (true)
+	{
+		const uint32_t item = document_open(doc, DOC_NODE_LIST_ITEM, stream->indent, 0);
+	
+		RJD_RESULT_PROMOTE(advance_token(stream));
+		parse_text(doc, stream);
+		document_close(doc, item);
+		stream->cursor -= 1;
+
+		if (!rjd_result_isok(consume_token(stream, TOKEN_TYPE_ASTERISK))) {
+			break;
+		}
+	}
+
+	stream->indent -= 1;
+	document_close(doc, list);
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_link(struct document* doc, struct token_stream* stream)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+	RJD_ASSERT(t->type == TOKEN_TYPE_SQUARE_BRACKET_OPEN);
+
+	bool open_new_tab = false;
+	const struct token* link_text_start = t + 1;
+
+	while (stream->cursor + 1 < rjd_array_count(stream->tokens) && !peek_token(stream, TOKEN_TYPE_SQUARE_BRACKET_CLOSE)) {
+		advance_token(stream);
+	}
+	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SQUARE_BRACKET_CLOSE));
+
+	const struct token* link_text_end = stream->tokens + stream->cursor;
+
+	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_PAREN_OPEN));
+
+	if (peek_token(stream, TOKEN_TYPE_SQUARE_BRACKET_OPEN)) {
+		RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SQUARE_BRACKET_OPEN));
+		RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_TEXT));
+
+		const struct token* attribute = stream->tokens + stream->cursor;
+
+		if (!strncmp("newtab", attribute->text, attribute->length)) {
+			open_new_tab = true;
+		} else {
+			return RJD_RESULT("unknown link attribute");
+		}
+		RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SQUARE_BRACKET_CLOSE));
+	}
+
+	RJD_RESULT_PROMOTE(advance_token(stream));
+	const struct token* text_begin = stream->tokens + stream->cursor;
+	const struct token* text_end = text_begin;
+
+	while (text_end->type != TOKEN_TYPE_PAREN_CLOSE)
+	{
+		RJD_RESULT_PROMOTE(advance_token(stream));
+		text_end = stream->tokens + stream->cursor;
+	}
+
+	const uint32_t node = document_open(doc, DOC_NODE_LINK, 0, open_new_tab ? 1 : 0);
+	doc->texts[node] = text_begin->text;
+	doc->lengths[node] = (uint32_t)(text_end->text - text_begin->text);
+	if (link_text_end->text > link_text_start->text) {
+		document_text(doc, DOC_NODE_TEXT, link_text_start->text, (uint32_t)(link_text_end->text - link_text_start->text));
+	}
+	document_close(doc, node);
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL uint32_t find_html_tag_length(const struct token* t)
+{
+	RJD_ASSERT(t->type == TOKEN_TYPE_TEXT);
+
+	for (uint32_t i = 0; i < t->length; ++i) {
+		if (!isspace((int)t->text[i])) {
+			return i;
+		}
+	}
+	return t->length;
+}
+
+// The newline before a block's closing tag is followed by an indent one level too deep, since
+// there was no way to know the closing tag was next. Takes one tab back off.
+GEN_INTERNAL void document_remove_trailing_tab(struct document* doc)
+{
+	const uint32_t count = document_count(doc);
+	if (count == 0) {
+		return;
+	}
+
+	const uint32_t last = count - 1;
+	if (doc->types[last] == DOC_NODE_HTML_NEWLINE && doc->indents[last] > 0) {
+		doc->indents[last] -= 1;
+	} else if (doc->types[last] == DOC_NODE_RAW && doc->lengths[last] > 0 && doc->texts[last][doc->lengths[last] - 1] == '\t') {
+		doc->lengths[last] -= 1;
+		doc->mergeable_node = UINT32_MAX;
+	}
+}
+
+GEN_INTERNAL struct rjd_result parse_html(struct document* doc, struct token_stream* stream)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+	RJD_ASSERT(t->type == TOKEN_TYPE_ANGLE_BRACKET_OPEN);
+
+	const uint32_t node = document_open(doc, DOC_NODE_HTML, stream->indent, 0);
+	document_text(doc, DOC_NODE_RAW, t->text, t->length);
+
+	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_TEXT));
+	t = stream->tokens + stream->cursor;
+	const struct token* html_tag = t;
+	const uint32_t html_tag_length = find_html_tag_length(t);
+
+	document_text(doc, DOC_NODE_RAW, t->text, t->length);
+	++stream->indent;
+
+	// Tag names are compared up to the length of the token that follows the <, so each token is only
+	// read a constant number of times however deep the tags go
+	int32_t tag_count = 1;
+	while (tag_count > 0)
+	{
+		RJD_RESULT_PROMOTE(advance_token(stream));
+		t = stream->tokens + stream->cursor;
+
+		const struct token* next = NULL;
+		const struct token* next2 = NULL;
+		if (stream->cursor + 2 < rjd_array_count(stream->tokens)) {
+			next = stream->tokens + stream->cursor + 1;
+			next2 = stream->tokens + stream->cursor + 2;
+		}
+
+		if (t->type == TOKEN_TYPE_ANGLE_BRACKET_OPEN &&
+			next && next->type == TOKEN_TYPE_TEXT)
+		{
+			uint32_t next_length = find_html_tag_length(next);
+			uint32_t length = rjd_math_min_u32(html_tag_length, next_length);
+
+			if (!strncmp(html_tag->text, next->text, length)) {
+				++tag_count;
+				++stream->indent;
+			}
+		}
+
+		if (t->type == TOKEN_TYPE_ANGLE_BRACKET_OPEN &&
+			next && next->type == TOKEN_TYPE_SLASH_FORWARD &&
+			next2 && next2->type == TOKEN_TYPE_TEXT)
+		{
+			uint32_t next2_length = find_html_tag_length(next2);
+			uint32_t length = rjd_math_min_u32(html_tag->length, next2_length);
+
+			if (!strncmp(html_tag->text, next2->text, length)) {
+				--tag_count;
+				--stream->indent;
+
+				if (tag_count == 0) {
+					document_remove_trailing_tab(doc);
+				}
+			}
+		}
+
+		if (t->type == TOKEN_TYPE_NEWLINE) {
+			document_push(doc, DOC_NODE_HTML_NEWLINE, stream->indent, 0, t->text, t->length);
+		} else {
+			document_text(doc, DOC_NODE_RAW, t->text, t->length);
+		}
+	}
+
+	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_SLASH_FORWARD));
+	t = stream->tokens + stream->cursor;
+	document_text(doc, DOC_NODE_RAW, t->text, t->length);
+
+	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_TEXT));
+	t = stream->tokens + stream->cursor;
+	document_text(doc, DOC_NODE_RAW, t->text, t->length);
+
+	RJD_RESULT_PROMOTE(consume_token(stream, TOKEN_TYPE_ANGLE_BRACKET_CLOSE));
+	t = stream->tokens + stream->cursor;
+	document_text(doc, DOC_NODE_RAW, t->text, t->length);
+
+	document_close(doc, node);
+
+	advance_token(stream);
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_quote(struct document* doc, struct token_stream* stream)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+	RJD_ASSERT(t->type == TOKEN_TYPE_ANGLE_BRACKET_CLOSE);
+
+	const uint32_t node = document_open(doc, DOC_NODE_QUOTE, stream->indent, 0);
+
+	while (t->type == TOKEN_TYPE_ANGLE_BRACKET_CLOSE && !stream_finished(stream))
+	{
+		advance_token(stream);
+		RJD_RESULT_PROMOTE(parse_text(doc, stream));
+
+		if (peek_token(stream, TOKEN_TYPE_NEWLINE)) {
+			advance_token(stream);
+		}
+
+		t = stream->tokens + stream->cursor;
+		if (t->type == TOKEN_TYPE_ANGLE_BRACKET_CLOSE) {
+			document_push(doc, DOC_NODE_QUOTE_BREAK, 0, 0, NULL, 0);
+		}
+	}
+
+	document_close(doc, node);
+
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result parse_code(struct document* doc, struct token_stream* stream, enum paragraph_position paragraph_position)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+	RJD_ASSERT(t->type == TOKEN_TYPE_BACKTICK);
+
+	const struct rjd_result result_missing_multiline_token = RJD_RESULT("Multiline token is 3 backticks on its own line, with an optional language text token.");
+
+	bool multiline = false;
+	uint16_t language = HIGHLIGHT_LANGUAGE_NONE;
+	if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
+		advance_token(stream);
+		if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
+			advance_token(stream);
+
+			// optional language token, which is left unhighlighted if it isn't one we know
+			if (peek_token(stream, TOKEN_TYPE_TEXT)) {
+				advance_token(stream);
+				t = stream->tokens + stream->cursor;
+				language = highlight_find_language(t->text, t->length);
+			}
+
+			if (peek_token(stream, TOKEN_TYPE_NEWLINE)) {
+				advance_token(stream);
+				multiline = true;
+			} else {
+				return result_missing_multiline_token;
+			}
+		} else {
+			return result_missing_multiline_token;
+		}
+	}
+
+	uint32_t node = 0;
+	if (multiline) {
+		node = document_open(doc, DOC_NODE_CODE_BLOCK, stream->indent, language);
+	} else if (paragraph_position == PARAGRAPH_POSITION_ROOT) {
+		// this is an inline code block, but we haven't started a paragraph yet, so start one
+		// now and let the inner parsing code recurse into this function
+		return parse_paragraph(doc, stream);
+	} else {
+		RJD_ASSERT(paragraph_position == PARAGRAPH_POSITION_INLINE);
+		node = document_open(doc, DOC_NODE_CODE_SPAN, 0, 0);
+	}
+
+	RJD_RESULT_PROMOTE(advance_token(stream));
+	t = stream->tokens + stream->cursor;
+
+	while (t->type != TOKEN_TYPE_BACKTICK) {
+		document_text(doc, DOC_NODE_TEXT, t->text, t->length);
+		RJD_RESULT_PROMOTE(advance_token(stream));
+		t = stream->tokens + stream->cursor;
+	}
+
+	if (multiline) {
+		if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
 			advance_token(stream);
+			if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
+				advance_token(stream);
+				if (peek_token(stream, TOKEN_TYPE_NEWLINE)) {
+					advance_token(stream);
+				} else {
+					return result_missing_multiline_token;
+				}
+			} else {
+				return result_missing_multiline_token;
+			}
+		}
+	}
+
+	document_close(doc, node);
+
+	return RJD_RESULT_OK();
+}
+
+enum emphasis
+{
+	EMPHASIS_ITALICS,
+	EMPHASIS_BOLD,
+	EMPHASIS_ITALICS_BOLD,
+	EMPHASIS_COUNT,
+};
+
+GEN_INTERNAL struct rjd_result parse_emphasis(struct document* doc, struct token_stream* stream)
+{
+	const struct token* t = stream->tokens + stream->cursor;
+	RJD_ASSERT(t->type == TOKEN_TYPE_UNDERSCORE);
+
+	// this underscore is in the middle of a word so it can't be emphasis
+	if (t != stream->tokens && isalpha((unsigned char)*(t->text - 1))) {
+		document_text(doc, DOC_NODE_TEXT, t->text, t->length);
+		return RJD_RESULT_OK();
+	}
+
+	enum emphasis emphasis = EMPHASIS_ITALICS;
+	while (rjd_result_isok(consume_token(stream, TOKEN_TYPE_UNDERSCORE))) {
+		++emphasis;
+	}
+
+	if (emphasis >= EMPHASIS_COUNT) {
+		return RJD_RESULT("Too many underscores for emphasis");
+	}
+
+	const uint32_t node = document_open(doc, DOC_NODE_EMPHASIS, 0, (uint16_t)emphasis);
+
+	t = stream->tokens + stream->cursor;
+	while (t->type != TOKEN_TYPE_UNDERSCORE) {
+		document_text(doc, DOC_NODE_TEXT, t->text, t->length);
+		RJD_RESULT_PROMOTE(advance_token(stream));
+		t = stream->tokens + stream->cursor;
+	}
+
+	document_close(doc, node);
+
+	// peek_token() is true past the end, so stop there or the cursor runs off forever
+	enum emphasis end_emphasis = EMPHASIS_ITALICS;
+	while (stream->cursor + 1 < rjd_array_count(stream->tokens) && peek_token(stream, TOKEN_TYPE_UNDERSCORE)) {
+		advance_token(stream);
+		++end_emphasis;
+	}
+
+	if (emphasis != end_emphasis) {
+		return RJD_RESULT("Emphasis begin/end mismatch");
+	}
+
+	return RJD_RESULT_OK();
+}
+
+// How far before the end of the tokens a block has to end to be complete when more text is still
+// coming: the last token may be text cut off mid-word, and parsers peek one token past where they stop.
+#define PARSE_LOOKAHEAD_TOKENS 2
+
+// Parses top-level blocks into the document. A block that fails to parse is left out, and parsing
+// stops there. Unless final, the tokens are only the start of the markdown, so a block that reaches
+// their end is left unparsed for the next call. consumed is how many tokens the parsed blocks used.
+GEN_INTERNAL struct rjd_result parse_document(struct document* doc, const struct token* tokens, bool final, uint32_t* consumed)
+{
+	struct token_stream stream =
+	{
+		.tokens = tokens,
+		.first_header_text = NULL,
+		.cursor = 0,
+		.indent = 1,
+	};
+
+	const uint32_t token_count = rjd_array_count(tokens);
+	struct rjd_result result = RJD_RESULT_OK();
+
+	while (stream.cursor < token_count)
+	{
+		const uint32_t block_begin = document_count(doc);
+		const uint32_t block_cursor = stream.cursor;
+		const struct token* block_header_text = stream.first_header_text;
+
+		switch (stream.tokens[stream.cursor].type)
+		{
+			case TOKEN_TYPE_NEWLINE:
+				// Markdown files with a newline at the end won't be able to advance the stream, reporting
+				// an error. Instead of propagating that error, just let the loop exit normally
+				advance_token(&stream);
+				break;
+			case TOKEN_TYPE_TEXT:
+			case TOKEN_TYPE_SQUARE_BRACKET_OPEN:
+			case TOKEN_TYPE_UNDERSCORE:
+				result = parse_paragraph(doc, &stream);
+				break;
+			case TOKEN_TYPE_HASH:
+				result = parse_header(doc, &stream);
+				break;
+			case TOKEN_TYPE_ASTERISK:
+				result = parse_list(doc, &stream);
+				break;
+			case TOKEN_TYPE_ANGLE_BRACKET_OPEN:
+				result = parse_html(doc, &stream);
+				break;
+			case TOKEN_TYPE_ANGLE_BRACKET_CLOSE:
+				result = parse_quote(doc, &stream);
+				break;
+			case TOKEN_TYPE_BACKTICK:
+				result = parse_code(doc, &stream, PARAGRAPH_POSITION_ROOT);
+				break;
+			default:
+				result = RJD_RESULT("unexpected token at top level");
+				break;
+		}
+
+		if (!final && (stream.cursor >= token_count || token_count - stream.cursor <= PARSE_LOOKAHEAD_TOKENS)) {
+			document_truncate(doc, block_begin);
+			stream.cursor = block_cursor;
+			stream.first_header_text = block_header_text;
+			result = RJD_RESULT_OK();
+			break;
+		}
+
+		if (!rjd_result_isok(result)) {
+			// drop the partially parsed block, leaving consumed at its start
+			document_truncate(doc, block_begin);
+			stream.cursor = block_cursor;
+			break;
+		}
+	}
+
+	doc->title = stream.first_header_text;
+	*consumed = rjd_math_min_u32(stream.cursor, token_count);
+	return result;
+}
+
+// --fingerprint also writes each stylesheet, script, image and font under a name with its content
+// hash, like global.3f9a2c1d.css, and points the site's references at that name so servers can
+// cache them as immutable. References are the src and href urls in the page template and in the
+// html blocks of pages. The plain name is still written for links from outside the site.
+GEN_INTERNAL const char* FINGERPRINTED_ASSET_EXTENSIONS[] =
+{
+	".css", ".js", ".mjs", ".png", ".jpg", ".jpeg", ".gif", ".webp", ".svg", ".ico", ".woff", ".woff2",
+};
+
+GEN_INTERNAL bool is_fingerprinted_asset(const char* path)
+{
+	for (uint32_t i = 0; i < rjd_countof(FINGERPRINTED_ASSET_EXTENSIONS); ++i) {
+		if (rjd_path_str_endswith(path, FINGERPRINTED_ASSET_EXTENSIONS[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// <img> tags in html blocks get a width and height read from the image's header so the page doesn't
+// shift as images load, plus loading="lazy" and decoding="async". These are the formats
+// read_image_size() understands.
+GEN_INTERNAL const char* SIZED_IMAGE_EXTENSIONS[] =
+{
+	".png", ".gif", ".jpg", ".jpeg",
+};
+
+GEN_INTERNAL bool is_sized_image(const char* path)
+{
+	for (uint32_t i = 0; i < rjd_countof(SIZED_IMAGE_EXTENSIONS); ++i) {
+		if (rjd_path_str_endswith(path, SIZED_IMAGE_EXTENSIONS[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+GEN_INTERNAL uint32_t read_u16_be(const uint8_t* bytes)
+{
+	return (uint32_t)bytes[0] << 8 | bytes[1];
+}
+
+GEN_INTERNAL uint32_t read_u32_be(const uint8_t* bytes)
+{
+	return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+}
+
+// Reads only as much of a PNG, GIF or JPEG as it takes to find the image's size
+GEN_INTERNAL bool read_image_size(const char* path, uint32_t* out_width, uint32_t* out_height)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	uint8_t header[24];
+	const size_t read = fread(header, 1, sizeof(header), file);
+	uint32_t width = 0;
+	uint32_t height = 0;
+	if (read >= 24 && !memcmp(header, "\x89PNG\r\n\x1a\n", 8) && !memcmp(header + 12, "IHDR", 4)) {
+		width = read_u32_be(header + 16);
+		height = read_u32_be(header + 20);
+	} else if (read >= 10 && (!memcmp(header, "GIF87a", 6) || !memcmp(header, "GIF89a", 6))) {
+		width = (uint32_t)header[7] << 8 | header[6];
+		height = (uint32_t)header[9] << 8 | header[8];
+	} else if (read >= 2 && header[0] == 0xFF && header[1] == 0xD8) {
+		// Seeks from segment to segment until the start of frame, which has the size
+		long offset = 2;
+		uint8_t segment[9];
+		while (fseek(file, offset, SEEK_SET) == 0 && fread(segment, 1, 4, file) == 4 && segment[0] == 0xFF) {
+			const uint8_t marker = segment[1];
+			const bool is_start_of_frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+			if (marker == 0xFF) {
+				++offset; // fill byte
+			} else if (is_start_of_frame) {
+				if (fread(segment + 4, 1, 5, file) == 5) {
+					height = read_u16_be(segment + 5);
+					width = read_u16_be(segment + 7);
+				}
+				break;
+			} else if (marker == 0xD9 || marker == 0xDA) {
+				break; // the image or its scan started without a frame
+			} else if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+				offset += 2; // markers without a length
+			} else {
+				offset += 2 + (long)read_u16_be(segment + 2);
+			}
+		}
+	}
+
+	fclose(file);
+	*out_width = width;
+	*out_height = height;
+	return width > 0 && height > 0;
+}
+
+struct asset_info
+{
+	uint64_t fingerprint; // 0 unless fingerprinting
+	uint32_t width; // 0 unless it's an image whose header could be read
+	uint32_t height;
+};
+
+// Built once per run before any page is rendered, since pages need the fingerprints and image sizes
+struct asset_map
+{
+	struct asset_info* infos; // rjd_array
+	struct rjd_dict lookup; // hash of the path relative to the source folder -> index+1 into infos
+	uint64_t hash; // of every path and info, so pages rebuild when any asset changes
+};
+
+GEN_INTERNAL const struct asset_info* asset_map_find(const struct asset_map* assets, const char* path)
+{
+	const uintptr_t index = (uintptr_t)rjd_dict_get(&assets->lookup, rjd_hash64_str(path));
+	return index ? assets->infos + index - 1 : NULL;
+}
+
+// global.css becomes global.3f9a2c1d.css. The fingerprint goes before the file name's last extension.
+GEN_INTERNAL void format_fingerprinted_path(char* out, size_t capacity, const char* path, size_t length, uint64_t fingerprint)
+{
+	size_t extension = length;
+	for (size_t i = length; i > 0 && path[i - 1] != '/'; --i) {
+		if (path[i - 1] == '.') {
+			extension = i - 1;
+			break;
+		}
+	}
+	snprintf(out, capacity, "%.*s.%08" PRIx32 "%.*s", (int)extension, path, (uint32_t)(fingerprint >> 32), 
+		(int)(length - extension), path + extension);
+}
+
+// Joins a url path onto a folder relative to the site root, collapsing . and .. segments. Fails if
+// the path climbs out of the site.
+GEN_INTERNAL bool resolve_site_path(char* out, size_t capacity, const char* folder, const char* path, uint32_t length)
+{
+	char joined[RJD_PATH_BUFFER_LENGTH];
+	const int joined_length = snprintf(joined, sizeof(joined), "%s%s%.*s", folder, folder[0] ? "/" : "", (int)length, path);
+	if (joined_length < 0 || (size_t)joined_length >= sizeof(joined)) {
+		return false;
+	}
+
+	size_t written = 0;
+	const char* end = joined + joined_length;
+	for (const char* segment = joined; segment < end;) {
+		const char* segment_end = memchr(segment, '/', (size_t)(end - segment));
+		if (segment_end == NULL) {
+			segment_end = end;
+		}
+		const size_t segment_length = (size_t)(segment_end - segment);
+
+		if (segment_length == 2 && segment[0] == '.' && segment[1] == '.') {
+			if (written == 0) {
+				return false;
+			}
+			while (written > 0 && out[written - 1] != '/') {
+				--written;
+			}
+			written -= written > 0 ? 1 : 0;
+		} else if (segment_length > 0 && !(segment_length == 1 && segment[0] == '.')) {
+			if (written + segment_length + 2 > capacity) {
+				return false;
+			}
+			if (written > 0) {
+				out[written++] = '/';
+			}
+			memcpy(out + written, segment, segment_length);
+			written += segment_length;
+		}
+		segment = segment_end + 1;
+	}
+
+	out[written] = '\0';
+	return written > 0;
+}
+
+// Finds the asset a url points at. Urls starting with / or {{root}} are from the site root, and
+// others from page_folder. The template is shared by pages in every folder, so it passes a NULL
+// page_folder and only its root urls are found. out_path_end is where the query or fragment starts.
+GEN_INTERNAL const struct asset_info* find_url_asset(const struct asset_map* assets, const char* page_folder, const char* url, uint32_t length, uint32_t* out_path_end)
+{
+	uint32_t path_end = 0;
+	while (path_end < length && url[path_end] != '?' && url[path_end] != '#') {
+		++path_end;
+	}
+	*out_path_end = path_end;
+
+	const char* folder = page_folder;
+	uint32_t path_begin = 0;
+	if (length >= 8 && !strncmp(url, "{{root}}", 8)) {
+		folder = "";
+		path_begin = 8;
+	} else if (length >= 1 && url[0] == '/' && !(length >= 2 && url[1] == '/')) {
+		folder = "";
+		path_begin = 1;
+	}
+
+	char resolved[RJD_PATH_BUFFER_LENGTH];
+	const bool is_local = folder != NULL && path_end > path_begin &&
+		memchr(url, ':', path_end) == NULL && // has a scheme, like https: or data:
+		resolve_site_path(resolved, sizeof(resolved), folder, url + path_begin, path_end - path_begin);
+	return is_local ? asset_map_find(assets, resolved) : NULL;
+}
+
+// Appends the url, pointing it at the fingerprinted name if the asset has one
+GEN_INTERNAL void append_asset_url(struct rjd_strbuf* out, const struct asset_map* assets, const char* page_folder, const char* url, uint32_t length)
+{
+	uint32_t path_end = 0;
+	const struct asset_info* info = find_url_asset(assets, page_folder, url, length, &path_end);
+	if (info && info->fingerprint) {
+		// the query or fragment is kept after the new name
+		char fingerprinted[RJD_PATH_BUFFER_LENGTH];
+		format_fingerprinted_path(fingerprinted, sizeof(fingerprinted), url, path_end, info->fingerprint);
+		rjd_strbuf_append(out, "%s", fingerprinted);
+		rjd_strbuf_appendl(out, url + path_end, length - path_end);
+	} else {
+		rjd_strbuf_appendl(out, url, length);
+	}
+}
+
+// Appends html with every quoted src and href value passed through append_asset_url()
+GEN_INTERNAL void append_html_urls(struct rjd_strbuf* out, const struct asset_map* assets, const char* page_folder, const char* html, uint32_t length)
+{
+	uint32_t copied = 0;
+	uint32_t i = 0;
+	while (i < length) {
+		const bool after_space = i > 0 && isspace((unsigned char)html[i - 1]);
+		uint32_t name_length = 0;
+		if (after_space && i + 4 < length && !strncmp(html + i, "src=", 4)) {
+			name_length = 4;
+		} else if (after_space && i + 5 < length && !strncmp(html + i, "href=", 5)) {
+			name_length = 5;
+		}
+
+		const char quote = name_length ? html[i + name_length] : '\0';
+		if (quote != '"' && quote != '\'') {
+			++i;
+			continue;
+		}
+
+		const uint32_t value = i + name_length + 1;
+		uint32_t value_end = value;
+		while (value_end < length && html[value_end] != quote) {
+			++value_end;
+		}
+
+		rjd_strbuf_appendl(out, html + copied, value - copied);
+		append_asset_url(out, assets, page_folder, html + value, value_end - value);
+		copied = value_end;
+		i = value_end;
+	}
+	rjd_strbuf_appendl(out, html + copied, length - copied);
+}
+
+// The index of the > that ends the tag starting at begin, skipping any inside quoted values. length
+// if the tag isn't closed.
+GEN_INTERNAL uint32_t find_tag_end(const char* html, uint32_t length, uint32_t begin)
+{
+	char quote = '\0';
+	uint32_t end = begin + 1;
+	while (end < length && (quote || html[end] != '>')) {
+		if (quote ? html[end] == quote : html[end] == '"' || html[end] == '\'') {
+			quote = quote ? '\0' : html[end];
+		}
+		++end;
+	}
+	return end;
+}
+
+// Finds name="value", name='value' or name=value in a tag. value may be NULL to only check for it.
+GEN_INTERNAL bool find_html_attribute(const char* tag, uint32_t length, const char* name, const char** out_value, uint32_t* out_value_length)
+{
+	const uint32_t name_length = (uint32_t)strlen(name);
+	for (uint32_t i = 1; i + name_length < length; ++i) {
+		if (!isspace((unsigned char)tag[i - 1]) || strncmp(tag + i, name, name_length) || tag[i + name_length] != '=') {
+			continue;
+		}
+
+		uint32_t value = i + name_length + 1;
+		const char quote = value < length && (tag[value] == '"' || tag[value] == '\'') ? tag[value] : '\0';
+		value += quote ? 1 : 0;
+		uint32_t value_end = value;
+		while (value_end < length && (quote ? tag[value_end] != quote : !isspace((unsigned char)tag[value_end]) && tag[value_end] != '>')) {
+			++value_end;
+		}
+
+		if (out_value) {
+			*out_value = tag + value;
+			*out_value_length = value_end - value;
+		}
+		return true;
+	}
+	return false;
+}
+
+// Appends an <img> tag with its size and lazy loading attributes added, unless the tag already has them
+GEN_INTERNAL void append_img_tag(struct rjd_strbuf* out, const struct asset_map* assets, const char* page_folder, const char* tag, uint32_t length)
+{
+	// added before the closing > or />
+	uint32_t insert = length - 1;
+	if (insert > 0 && tag[insert - 1] == '/') {
+		--insert;
+	}
+	while (insert > 0 && isspace((unsigned char)tag[insert - 1])) {
+		--insert;
+	}
+	append_html_urls(out, assets, page_folder, tag, insert);
+
+	const char* src = NULL;
+	uint32_t src_length = 0;
+	const bool is_sized = find_html_attribute(tag, length, "width", NULL, NULL) || find_html_attribute(tag, length, "height", NULL, NULL);
+	if (!is_sized && find_html_attribute(tag, length, "src", &src, &src_length)) {
+		uint32_t path_end = 0;
+		const struct asset_info* info = find_url_asset(assets, page_folder, src, src_length, &path_end);
+		if (info && info->width > 0) {
+			rjd_strbuf_append(out, " width=\"%u\" height=\"%u\"", info->width, info->height);
+		}
+	}
+	if (!find_html_attribute(tag, length, "loading", NULL, NULL)) {
+		rjd_strbuf_append(out, " loading=\"lazy\"");
+	}
+	if (!find_html_attribute(tag, length, "decoding", NULL, NULL)) {
+		rjd_strbuf_append(out, " decoding=\"async\"");
+	}
+
+	rjd_strbuf_appendl(out, tag + insert, length - insert);
+}
+
+// Appends html with its asset urls rewritten by append_html_urls() and its <img> tags filled out by
+// append_img_tag()
+GEN_INTERNAL void append_html_with_assets(struct rjd_strbuf* out, const struct asset_map* assets, const char* page_folder, const char* html, uint32_t length)
+{
+	uint32_t copied = 0;
+	for (uint32_t i = 0; i + 4 < length; ++i) {
+		const bool is_img = html[i] == '<' && !strncmp(html + i + 1, "img", 3) && 
+			(isspace((unsigned char)html[i + 4]) || html[i + 4] == '/' || html[i + 4] == '>');
+		if (!is_img) {
+			continue;
+		}
+
+		const uint32_t tag_end = find_tag_end(html, length, i);
+		if (tag_end == length) {
+			break;
+		}
+
+		append_html_urls(out, assets, page_folder, html + copied, i - copied);
+		append_img_tag(out, assets, page_folder, html + i, tag_end + 1 - i);
+		copied = tag_end + 1;
+		i = tag_end;
+	}
+	append_html_urls(out, assets, page_folder, html + copied, length - copied);
+}
+
+// With minify set, rendering leaves out the indentation and the newlines between blocks, counting
+// the bytes it saved. Code blocks are untouched since their whitespace is content. With assets set,
+// html blocks go through append_html_with_assets().
+struct render_state
+{
+	bool minify;
+	uint32_t minified_bytes;
+	const struct asset_map* assets; // NULL when streaming, since there's no source tree
+	const char* page_folder; // relative to the site root
+	struct rjd_strbuf* html; // an html block before its assets are filled in
+};
+
+// Blocks nested deeper than this aren't indented any further. Otherwise every line of deeply
+// nested html would be indented by its depth, and the page would grow with the square of it.
+#define RENDER_MAX_INDENT 16
+
+GEN_INTERNAL void render_indent(struct render_state* state, int32_t indent, struct rjd_strbuf* out)
+{
+	indent = rjd_math_min_i32(indent, RENDER_MAX_INDENT);
+	if (state->minify) {
+		state->minified_bytes += (uint32_t)indent;
+	} else {
+		append_indent(out, indent);
+	}
+}
+
+GEN_INTERNAL void render_newline(struct render_state* state, struct rjd_strbuf* out)
+{
+	if (state->minify) {
+		++state->minified_bytes;
+	} else {
+		rjd_strbuf_append(out, "\n");
+	}
+}
+
+GEN_INTERNAL void render_node(const struct document* doc, uint32_t node, struct render_state* state, struct rjd_strbuf* out);
+
+GEN_INTERNAL void render_children(const struct document* doc, uint32_t node, struct render_state* state, struct rjd_strbuf* out)
+{
+	for (uint32_t child = node + 1; child < doc->ends[node]; child = doc->ends[child]) {
+		render_node(doc, child, state, out);
+	}
+}
+
+GEN_INTERNAL void render_node(const struct document* doc, uint32_t node, struct render_state* state, struct rjd_strbuf* out)
+{
+	static const char* emphasis_styles[] = 
+	{
+		"text-emphasis-1",
+		"text-emphasis-2",
+		"text-emphasis-3",
+	};
+	RJD_STATIC_ASSERT(rjd_countof(emphasis_styles) == EMPHASIS_COUNT);
+
+	const uint16_t value = doc->values[node];
+	switch ((enum doc_node_type)doc->types[node])
+	{
+		case DOC_NODE_PARAGRAPH:
+			render_indent(state, doc->indents[node], out);
+			if (value) {
+				rjd_strbuf_append(out, "<p>");
+			}
+			render_children(doc, node, state, out);
+			if (value) {
+				rjd_strbuf_append(out, "</p>");
+				render_newline(state, out);
+			} else {
+				// An unwrapped paragraph is inline, so the newline keeps it apart from the next one
+				rjd_strbuf_append(out, "\n");
+			}
+			break;
+		case DOC_NODE_HEADER:
+			render_indent(state, doc->indents[node], out);
+			rjd_strbuf_append(out, "<h%d>", value);
+			render_children(doc, node, state, out);
+			rjd_strbuf_append(out, "</h%d>", value);
+			render_newline(state, out);
+			break;
+		case DOC_NODE_LIST:
+			render_indent(state, doc->indents[node], out);
+			rjd_strbuf_append(out, "<ul>");
+			render_newline(state, out);
+			render_children(doc, node, state, out);
+			render_indent(state, doc->indents[node], out);
+			rjd_strbuf_append(out, "</ul>");
+			render_newline(state, out);
+			break;
+		case DOC_NODE_LIST_ITEM:
+			render_indent(state, doc->indents[node], out);
+			rjd_strbuf_append(out, "<li>");
+			render_children(doc, node, state, out);
+			rjd_strbuf_append(out, "</li>");
+			render_newline(state, out);
+			break;
+		case DOC_NODE_QUOTE:
+			render_indent(state, doc->indents[node], out);
+			rjd_strbuf_append(out, "<p class=\"quote\">");
+			render_children(doc, node, state, out);
+			rjd_strbuf_append(out, "</p>");
+			render_newline(state, out);
+			break;
+		case DOC_NODE_HTML:
+			render_indent(state, doc->indents[node], out);
+			if (state->assets && out != state->html) {
+				// a tag can be split over several nodes, so the whole block is rendered before rewriting
+				rjd_strbuf_clear(state->html);
+				render_children(doc, node, state, state->html);
+				append_html_with_assets(out, state->assets, state->page_folder, rjd_strbuf_str(state->html), state->html->length);
+			} else {
+				render_children(doc, node, state, out);
+			}
+			// Raw html may end with an inline element, so its newline stays
+			rjd_strbuf_append(out, "\n");
+			break;
+		case DOC_NODE_CODE_BLOCK:
+			render_indent(state, doc->indents[node], out);
+			if (value == HIGHLIGHT_LANGUAGE_NONE) {
+				rjd_strbuf_append(out, "<pre><code class=\"hljs\">");
+				render_children(doc, node, state, out);
+			} else {
+				const struct highlight_language* language = HIGHLIGHT_LANGUAGES + value - 1;
+				rjd_strbuf_append(out, "<pre><code class=\"hljs language-%s\">", language->names[0]);
+				for (uint32_t child = node + 1; child < doc->ends[node]; child = doc->ends[child]) {
+					append_highlighted(out, language, doc->texts[child], doc->lengths[child]);
+				}
+			}
+			rjd_strbuf_append(out, "</code></pre>");
+			render_newline(state, out);
+			break;
+		case DOC_NODE_TEXT:
+			append_html_escaped(out, doc->texts[node], doc->lengths[node]);
+			break;
+		case DOC_NODE_RAW:
+			rjd_strbuf_appendl(out, doc->texts[node], doc->lengths[node]);
+			break;
+		case DOC_NODE_HTML_NEWLINE:
+			rjd_strbuf_appendl(out, doc->texts[node], doc->lengths[node]);
+			render_indent(state, doc->indents[node], out);
+			break;
+		case DOC_NODE_QUOTE_BREAK:
+			rjd_strbuf_append(out, "<br>");
+			break;
+		case DOC_NODE_CODE_SPAN:
+			rjd_strbuf_append(out, "<span class=\"inline-code\">");
+			render_children(doc, node, state, out);
+			rjd_strbuf_append(out, "</span>");
+			break;
+		case DOC_NODE_EMPHASIS:
+			rjd_strbuf_append(out, "<span class=\"%s\">", emphasis_styles[value]);
+			render_children(doc, node, state, out);
+			rjd_strbuf_append(out, "</span>");
+			break;
+		case DOC_NODE_LINK:
+			rjd_strbuf_append(out, "<a href=\"");
+			append_html_escaped(out, doc->texts[node], doc->lengths[node]);
+			rjd_strbuf_append(out, "\"");
+			if (value) {
+				rjd_strbuf_append(out, " target=\"_blank\"");
+			}
+			rjd_strbuf_append(out, ">");
+			render_children(doc, node, state, out);
+			rjd_strbuf_append(out, "</a>");
+			break;
+	}
+}
+
+// Renders the page body, returning the number of top-level blocks
+GEN_INTERNAL uint32_t render_document(const struct document* doc, struct render_state* state, struct rjd_strbuf* out)
+{
+	uint32_t block_count = 0;
+	for (uint32_t node = 0; node < document_count(doc); node = doc->ends[node]) {
+		render_node(doc, node, state, out);
+		++block_count;
+	}
+	return block_count;
+}
+
+// Pages are rendered from a template with {{field}} slots for the page's fields and one {{body}}
+// slot for the rendered markdown. {{?field}}...{{/field}} is only output if the page has that
+// field, and {{style}} is where --critical-css puts the page's <style>. The template is compiled
+// once into a list of ops, so rendering a page is just copying literals and field values.
+enum page_field
+{
+	PAGE_FIELD_TITLE, // text of the page's first header
+	PAGE_FIELD_ROOT, // relative path from the page back to the site root, e.g. "../../"
+	PAGE_FIELD_PATH, // the page's path from the site root
+	PAGE_FIELD_DATE, // YYYY-MM-DD, from the name of the folder the page is in
+	PAGE_FIELD_COUNT,
+};
+
+GEN_INTERNAL const char* PAGE_FIELD_NAMES[] =
+{
+	"title",
+	"root",
+	"path",
+	"date",
+};
+RJD_STATIC_ASSERT(rjd_countof(PAGE_FIELD_NAMES) == PAGE_FIELD_COUNT);
+
+// A field is missing if its length is 0
+struct page_fields
+{
+	const char* values[PAGE_FIELD_COUNT];
+	uint32_t lengths[PAGE_FIELD_COUNT];
+	const char* style; // css for {{style}}, which isn't escaped
+	uint32_t style_length;
+};
+
+enum template_op_type
+{
+	TEMPLATE_OP_LITERAL,
+	TEMPLATE_OP_FIELD,
+	TEMPLATE_OP_SECTION,
+	TEMPLATE_OP_BODY,
+	TEMPLATE_OP_STYLE,
+};
+
+struct template_op
+{
+	enum template_op_type type;
+	enum page_field field;
+	uint32_t offset; // literal: offset into the template text
+	uint32_t length; // literal: byte count. section: number of ops to skip if the field is missing
+};
+
+struct page_template
+{
+	char* text; // rjd_array
+	struct template_op* ops; // rjd_array
+	uint32_t body_op; // ops before this are the page header, and after it the footer
+	uint64_t hash;
+	uint32_t minified_bytes; // whitespace --minify removed from the template
+	struct rjd_path* stylesheets; // rjd_array of the site paths of the stylesheets made async for --critical-css
+	const struct critical_css* critical_css; // NULL unless pages get a {{style}}
+};
+
+// Keep in sync with templates/page.html
+GEN_INTERNAL const char DEFAULT_PAGE_TEMPLATE[] =
+	"<!DOCTYPE html>\n"
+	"<html>\n"
+	"<head>\n"
+	"{{?title}}\t<title>{{title}} | Reuben Dunnington</title>{{/title}}\n"
+	"\t<meta charset=\"UTF-8\">\n"
+	"\t<meta name=\"description\" content=\"Personal website with a blog and resume.\">\n"
+	"\t<meta name=\"keywords\" content=\"programming, blog\">\n"
+	"\t<meta name=\"author\" content=\"Reuben Dunnington\">\n"
+	"\t<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
+	"\t<link rel=\"stylesheet\" type=\"text/css\" href=\"{{root}}styles/global.css\">\n"
+	"\t<link rel=\"stylesheet\" type=\"text/css\" href=\"{{root}}script/highlight/monokai.css\">\n"
+	"</head>\n"
+	"<body>\n"
+	"\t<nav>\n"
+	"\t\t<a href=\"/\">Home</a>\n"
+	"\t\t<a href=\"/resume\">Resume</a>\n"
+	"\t\t<a href=\"/projects\">Projects</a>\n"
+	"\t\t<a href=\"/blog\">Blog</a>\n"
+	"\t</nav>\n"
+	"{{body}}"
+	"</body>\n"
+	"</html>\n";
+
+#define PAGE_TEMPLATE_MAX_SECTION_DEPTH 8
+
+GEN_INTERNAL void page_template_free(struct page_template* template)
+{
+	if (template->text) {
+		rjd_array_free(template->text);
+	}
+	if (template->ops) {
+		rjd_array_free(template->ops);
+	}
+	if (template->stylesheets) {
+		rjd_array_free(template->stylesheets);
+	}
+	memset(template, 0, sizeof(*template));
+}
+
+// Appends html with each <link rel="stylesheet"> from the site root loading without blocking the
+// first paint: it starts as media="print", which isn't render-blocking, and switches to all once
+// it's loaded. A <noscript> keeps the original tag for browsers without scripts. The first one gets
+// a {{style}} before it unless the html already has one, and the paths are pushed onto stylesheets.
+GEN_INTERNAL void append_html_with_async_styles(struct rjd_strbuf* out, const char* html, uint32_t length, struct rjd_path** stylesheets)
+{
+	bool has_style_slot = false;
+	for (uint32_t i = 0; i + 9 <= length && !has_style_slot; ++i) {
+		has_style_slot = !strncmp(html + i, "{{style}}", 9);
+	}
+
+	uint32_t copied = 0;
+	for (uint32_t i = 0; i + 5 < length; ++i) {
+		const bool is_link = html[i] == '<' && !strncmp(html + i + 1, "link", 4) && isspace((unsigned char)html[i + 5]);
+		if (!is_link) {
+			continue;
+		}
+
+		const uint32_t tag_end = find_tag_end(html, length, i);
+		if (tag_end == length) {
+			break;
+		}
+		const char* tag = html + i;
+		const uint32_t tag_length = tag_end + 1 - i;
+
+		const char* rel = NULL;
+		const char* href = NULL;
+		uint32_t rel_length = 0;
+		uint32_t href_length = 0;
+		const bool is_stylesheet = find_html_attribute(tag, tag_length, "rel", &rel, &rel_length) && 
+			rel_length == 10 && !strncmp(rel, "stylesheet", 10) &&
+			!find_html_attribute(tag, tag_length, "media", NULL, NULL) &&
+			find_html_attribute(tag, tag_length, "href", &href, &href_length);
+
+		// only the stylesheets with a root url can be read once for every page
+		uint32_t path_begin = 0;
+		if (is_stylesheet && href_length > 8 && !strncmp(href, "{{root}}", 8)) {
+			path_begin = 8;
+		} else if (is_stylesheet && href_length > 1 && href[0] == '/' && href[1] != '/') {
+			path_begin = 1;
+		}
+		uint32_t path_end = path_begin;
+		while (path_end < href_length && href[path_end] != '?' && href[path_end] != '#') {
+			++path_end;
+		}
+
+		char path[RJD_PATH_BUFFER_LENGTH];
+		if (path_begin == 0 || memchr(href, ':', path_end) || 
+			!resolve_site_path(path, sizeof(path), "", href + path_begin, path_end - path_begin)) {
+			i = tag_end;
+			continue;
+		}
+
+		// the {{style}} gets its own line, indented like the link
+		uint32_t line_start = i;
+		while (line_start > copied && (html[line_start - 1] == ' ' || html[line_start - 1] == '\t')) {
+			--line_start;
+		}
+		rjd_strbuf_appendl(out, html + copied, i - copied);
+		if (!has_style_slot) {
+			rjd_strbuf_append(out, "{{style}}\n");
+			rjd_strbuf_appendl(out, html + line_start, i - line_start);
+			has_style_slot = true;
+		}
+
+		uint32_t insert = tag_length - 1;
+		if (insert > 0 && tag[insert - 1] == '/') {
+			--insert;
+		}
+		while (insert > 0 && isspace((unsigned char)tag[insert - 1])) {
+			--insert;
+		}
+		rjd_strbuf_appendl(out, tag, insert);
+		rjd_strbuf_append(out, " media=\"print\" onload=\"this.media='all'\"");
+		rjd_strbuf_appendl(out, tag + insert, tag_length - insert);
+		rjd_strbuf_append(out, "<noscript>");
+		rjd_strbuf_appendl(out, tag, tag_length);
+		rjd_strbuf_append(out, "</noscript>");
+
+		struct rjd_path stylesheet = rjd_path_init_with(path);
+		rjd_array_push(*stylesheets, stylesheet);
+
+		copied = tag_end + 1;
+		i = tag_end;
+	}
+	rjd_strbuf_appendl(out, html + copied, length - copied);
+}
+
+// Minifying drops the indentation and blank lines of the template itself. The newlines stay so
+// inline elements on separate lines, like the nav links, keep the space between them. assets may
+// be NULL, otherwise the template's html goes through append_html_with_assets(). With async_styles,
+// its stylesheets are loaded by append_html_with_async_styles() first.
+GEN_INTERNAL struct rjd_result page_template_parse(struct page_template* template, const char* text, size_t length, bool minify, 
+	bool async_styles, const struct asset_map* assets, struct rjd_mem_allocator* alloc)
+{
+	template->stylesheets = rjd_array_alloc(struct rjd_path, 4, alloc);
+	struct rjd_strbuf with_async_styles = rjd_strbuf_init(alloc);
+	if (async_styles) {
+		append_html_with_async_styles(&with_async_styles, text, (uint32_t)length, &template->stylesheets);
+		text = rjd_strbuf_str(&with_async_styles);
+		length = with_async_styles.length;
+	}
+
+	struct rjd_strbuf with_assets = rjd_strbuf_init(alloc);
+	if (assets) {
+		append_html_with_assets(&with_assets, assets, NULL, text, (uint32_t)length);
+		text = rjd_strbuf_str(&with_assets);
+		length = with_assets.length;
+	}
+
+	template->text = rjd_array_alloc(char, length + 1, alloc);
+	if (minify) {
+		bool line_start = true;
+		for (size_t i = 0; i < length; ++i) {
+			const char c = text[i];
+			if (line_start && (c == ' ' || c == '\t' || c == '\r' || c == '\n')) {
+				continue;
+			}
+			// A section tag that opens a line is copied whole, and the indentation after it
+			// is stripped as well
+			if (line_start && c == '{' && i + 2 < length && text[i + 1] == '{' &&
+				(text[i + 2] == '?' || text[i + 2] == '/')) {
+				size_t end = i + 3;
+				while (end + 1 < length && !(text[end] == '}' && text[end + 1] == '}')) {
+					++end;
+				}
+				if (end + 1 < length) {
+					for (; i < end + 2; ++i) {
+						rjd_array_push(template->text, text[i]);
+					}
+					--i;
+					continue;
+				}
+			}
+			line_start = c == '\n';
+			rjd_array_push(template->text, c);
+		}
+		template->minified_bytes = (uint32_t)(length - rjd_array_count(template->text));
+		length = rjd_array_count(template->text);
+	} else {
+		rjd_array_resize(template->text, (uint32_t)length);
+		memcpy(template->text, text, length);
+	}
+	template->text[length] = '\0'; // past the count, but in capacity, so strstr stops at the end
+	template->ops = rjd_array_alloc(struct template_op, 32, alloc);
+	template->body_op = UINT32_MAX;
+	template->hash = rjd_hash64_data((const uint8_t*)template->text, length).value;
+	rjd_strbuf_free(&with_assets);
+	rjd_strbuf_free(&with_async_styles);
+
+	uint32_t sections[PAGE_TEMPLATE_MAX_SECTION_DEPTH];
+	uint32_t section_depth = 0;
+	struct rjd_result result = RJD_RESULT_OK();
+
+	const char* begin = template->text;
+	const char* end = begin + length;
+	const char* next = begin;
+	while (next < end && rjd_result_isok(result))
+	{
+		const char* slot = strstr(next, "{{");
+		if (slot == NULL) {
+			slot = end;
+		}
+
+		if (slot > next) {
+			struct template_op literal = {
+				.type = TEMPLATE_OP_LITERAL,
+				.offset = (uint32_t)(next - begin),
+				.length = (uint32_t)(slot - next),
+			};
+			rjd_array_push(template->ops, literal);
+		}
+
+		if (slot == end) {
+			break;
+		}
+
+		const char* name = slot + 2;
+		const char* name_end = strstr(name, "}}");
+		if (name_end == NULL) {
+			result = RJD_RESULT("unterminated {{ in template");
+			break;
+		}
+		next = name_end + 2;
+
+		const char kind = *name;
+		if (kind == '?' || kind == '/') {
+			++name;
+		}
+
+		if (kind != '?' && kind != '/' && name_end - name == 4 && !strncmp(name, "body", 4)) {
+			if (template->body_op != UINT32_MAX) {
+				result = RJD_RESULT("template has more than one {{body}}");
+			} else if (section_depth > 0) {
+				result = RJD_RESULT("{{body}} can't be inside a {{?section}}");
+			} else {
+				template->body_op = rjd_array_count(template->ops);
+				struct template_op body = { .type = TEMPLATE_OP_BODY };
+				rjd_array_push(template->ops, body);
+			}
+			continue;
+		}
+
+		if (kind != '?' && kind != '/' && name_end - name == 5 && !strncmp(name, "style", 5)) {
+			struct template_op style = { .type = TEMPLATE_OP_STYLE };
+			rjd_array_push(template->ops, style);
+			continue;
+		}
+
+		enum page_field field = PAGE_FIELD_COUNT;
+		for (uint32_t i = 0; i < PAGE_FIELD_COUNT; ++i) {
+			if ((size_t)(name_end - name) == strlen(PAGE_FIELD_NAMES[i]) && !strncmp(name, PAGE_FIELD_NAMES[i], name_end - name)) {
+				field = (enum page_field)i;
+			}
+		}
+		if (field == PAGE_FIELD_COUNT) {
+			result = RJD_RESULT("unknown field in template");
+			break;
+		}
+
+		if (kind == '?') {
+			if (section_depth == PAGE_TEMPLATE_MAX_SECTION_DEPTH) {
+				result = RJD_RESULT("template sections are nested too deeply");
+				break;
+			}
+			sections[section_depth++] = rjd_array_count(template->ops);
+			struct template_op section = { .type = TEMPLATE_OP_SECTION, .field = field };
+			rjd_array_push(template->ops, section);
+		} else if (kind == '/') {
+			if (section_depth == 0 || template->ops[sections[section_depth - 1]].field != field) {
+				result = RJD_RESULT("{{/field}} doesn't match the open {{?field}}");
+				break;
+			}
+			const uint32_t section_op = sections[--section_depth];
+			template->ops[section_op].length = rjd_array_count(template->ops) - section_op - 1;
+		} else {
+			struct template_op slot_op = { .type = TEMPLATE_OP_FIELD, .field = field };
+			rjd_array_push(template->ops, slot_op);
+		}
+	}
+
+	if (rjd_result_isok(result) && section_depth > 0) {
+		result = RJD_RESULT("template has an unclosed {{?section}}");
+	}
+	if (rjd_result_isok(result) && template->body_op == UINT32_MAX) {
+		result = RJD_RESULT("template has no {{body}}");
+	}
+
+	if (!rjd_result_isok(result)) {
+		page_template_free(template);
+	}
+	return result;
+}
+
+// A NULL path loads DEFAULT_PAGE_TEMPLATE
+GEN_INTERNAL struct rjd_result page_template_load(struct page_template* template, const char* path, bool minify, 
+	bool async_styles, const struct asset_map* assets, struct rjd_mem_allocator* alloc)
+{
+	if (path == NULL) {
+		return page_template_parse(template, DEFAULT_PAGE_TEMPLATE, strlen(DEFAULT_PAGE_TEMPLATE), minify, async_styles, assets, alloc);
+	}
+
+	char* contents = NULL;
+	RJD_RESULT_PROMOTE(rjd_fio_read(path, &contents, alloc));
+	struct rjd_result result = page_template_parse(template, contents, rjd_array_count(contents), minify, async_styles, assets, alloc);
+	rjd_array_free(contents);
+	return result;
+}
+
+// Renders ops [begin, end), skipping the body
+GEN_INTERNAL void page_template_render(const struct page_template* template, uint32_t begin, uint32_t end, const struct page_fields* fields, struct rjd_strbuf* out)
+{
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		const struct template_op* op = template->ops + i;
+		switch (op->type)
+		{
+			case TEMPLATE_OP_LITERAL:
+				rjd_strbuf_appendl(out, template->text + op->offset, op->length);
+				break;
+			case TEMPLATE_OP_FIELD:
+				append_html_escaped(out, fields->values[op->field], fields->lengths[op->field]);
+				break;
+			case TEMPLATE_OP_SECTION:
+				if (fields->lengths[op->field] == 0) {
+					i += op->length;
+				}
+				break;
+			case TEMPLATE_OP_BODY:
+				break;
+			case TEMPLATE_OP_STYLE:
+				if (fields->style_length > 0) {
+					rjd_strbuf_append(out, "<style>");
+					rjd_strbuf_appendl(out, fields->style, fields->style_length);
+					rjd_strbuf_append(out, "</style>");
+				}
+				break;
+		}
+	}
+}
+
+GEN_INTERNAL void page_fields_set(struct page_fields* fields, enum page_field field, const char* value, size_t length)
+{
+	fields->values[field] = value;
+	fields->lengths[field] = (uint32_t)length;
+}
+
+// The {{root}} of a page that isn't part of a build: a ".." for each folder it's in, like
+// build_job_init() computes
+GEN_INTERNAL struct rjd_path page_root_path(const char* path_relative)
+{
+	struct rjd_path root = rjd_path_init();
+	for (const char* next = path_relative; *next; ++next) {
+		if (*next == '/') {
+			rjd_path_join_str(&root, "..");
+		}
+	}
+	if (root.length > 0) {
+		rjd_path_append(&root, "/");
+	}
+	return root;
+}
+
+// Fills out the fields that only depend on where the page is. The strings must outlive the fields.
+GEN_INTERNAL void page_fields_init(struct page_fields* fields, const char* path_relative, const char* path_root)
+{
+	memset(fields, 0, sizeof(*fields));
+	page_fields_set(fields, PAGE_FIELD_ROOT, path_root, strlen(path_root));
+	page_fields_set(fields, PAGE_FIELD_PATH, path_relative, strlen(path_relative));
+
+	// blog posts live in folders like blog/2020-05-18/
+	for (const char* next = path_relative; *next; ++next) {
+		const bool at_folder_start = next == path_relative || next[-1] == '/';
+		const char* d = next;
+		if (at_folder_start && strlen(d) > 10 && d[10] == '/' && d[4] == '-' && d[7] == '-' &&
+			isdigit((int)d[0]) && isdigit((int)d[1]) && isdigit((int)d[2]) && isdigit((int)d[3]) &&
+			isdigit((int)d[5]) && isdigit((int)d[6]) && isdigit((int)d[8]) && isdigit((int)d[9]))
+		{
+			page_fields_set(fields, PAGE_FIELD_DATE, d, 10);
+			break;
+		}
+	}
+}
+
+// What the blog index and feed need to know about a page. It's kept in the manifest so pages that
+// are up to date don't have to be read again to build the index. All of it is plain text.
+#define PAGE_META_TITLE_LENGTH 128
+#define PAGE_META_SUMMARY_LENGTH 256
+#define PAGE_META_DATE_LENGTH 11
+
+struct page_meta
+{
+	char title[PAGE_META_TITLE_LENGTH];
+	char summary[PAGE_META_SUMMARY_LENGTH];
+	char date[PAGE_META_DATE_LENGTH]; // YYYY-MM-DD, empty unless the page is in a dated folder
+};
+
+// Appends text to a page_meta string, collapsing runs of whitespace into one space so it fits on a
+// manifest line. Text that doesn't fit is cut at the last word that does, or mid-word if it has
+// no spaces, and marked with "...". Returns false once the string is full.
+GEN_INTERNAL bool page_meta_append(char* dst, size_t capacity, const char* text, size_t length)
+{
+	size_t used = strlen(dst);
+	for (size_t i = 0; i < length; ++i) {
+		const bool is_space = isspace((int)(unsigned char)text[i]) != 0;
+		if (is_space && (used == 0 || dst[used - 1] == ' ')) {
+			continue;
+		}
+
+		if (used + 1 >= capacity) {
+			const char ellipsis[] = "...";
+			const size_t hard_cut = rjd_math_min_sizet(used, capacity - sizeof(ellipsis));
+			size_t cut = hard_cut;
+			while (cut > 0 && dst[cut] != ' ') {
+				--cut;
+			}
+
+			// Text without spaces, like a url or CJK prose, is cut mid-word instead, but not
+			// inside a UTF-8 sequence
+			if (cut == 0) {
+				cut = hard_cut;
+				while (cut > 0 && ((unsigned char)dst[cut] & 0xC0) == 0x80) {
+					--cut;
+				}
+			}
+			memcpy(dst + cut, ellipsis, sizeof(ellipsis));
+			return false;
+		}
+		dst[used++] = is_space ? ' ' : text[i];
+		dst[used] = '\0';
+	}
+	return true;
+}
+
+GEN_INTERNAL void page_meta_trim(char* str)
+{
+	size_t length = strlen(str);
+	while (length > 0 && str[length - 1] == ' ') {
+		str[--length] = '\0';
+	}
+}
+
+// The summary is the text of the page's first paragraph, without any markup
+GEN_INTERNAL void page_meta_init(struct page_meta* meta, const struct document* doc, const struct page_fields* fields)
+{
+	memset(meta, 0, sizeof(*meta));
+
+	if (doc->title) {
+		page_meta_append(meta->title, sizeof(meta->title), doc->title->text, doc->title->length);
+		page_meta_trim(meta->title);
+	}
+
+	if (fields->lengths[PAGE_FIELD_DATE] + 1 == sizeof(meta->date)) {
+		memcpy(meta->date, fields->values[PAGE_FIELD_DATE], fields->lengths[PAGE_FIELD_DATE]);
+	}
+
+	for (uint32_t node = 0; node < document_count(doc); node = doc->ends[node]) {
+		if (doc->types[node] != DOC_NODE_PARAGRAPH) {
+			continue;
+		}
+
+		for (uint32_t child = node + 1; child < doc->ends[node]; ++child) {
+			if (doc->types[child] == DOC_NODE_TEXT && 
+				!page_meta_append(meta->summary, sizeof(meta->summary), doc->texts[child], doc->lengths[child])) {
+				break;
+			}
+		}
+		page_meta_trim(meta->summary);
+		break;
+	}
+}
+
+struct output_span
+{
+	const char* data;
+	size_t length;
+};
+
+// Writes the spans in order to a temp file next to path with a single writev, then renames it into
+// place so nothing ever sees a half-written file.
+GEN_INTERNAL struct rjd_result write_file_atomic(const char* path, const struct output_span* spans, uint32_t span_count)
+{
+	struct rjd_path path_temp = rjd_path_init_with(path);
+	rjd_path_append(&path_temp, ".tmp");
+
+#if GEN_POSIX
+	int fd = open(rjd_path_get(&path_temp), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return RJD_RESULT("Failed to open output file path for write");
+	}
+
+	struct iovec iov[8];
+	RJD_ASSERT(span_count <= rjd_countof(iov));
+	for (uint32_t i = 0; i < span_count; ++i) {
+		iov[i].iov_base = (void*)spans[i].data;
+		iov[i].iov_len = spans[i].length;
+	}
+
+	// writev is allowed to write less than asked, so pick up where it left off until everything is out
+	struct iovec* remaining = iov;
+	int remaining_count = (int)span_count;
+	bool ok = true;
+	while (remaining_count > 0) {
+		ssize_t written = writev(fd, remaining, remaining_count);
+		if (written < 0) {
+			ok = false;
+			break;
+		}
+		while (remaining_count > 0 && (size_t)written >= remaining->iov_len) {
+			written -= (ssize_t)remaining->iov_len;
+			++remaining;
+			--remaining_count;
+		}
+		if (remaining_count > 0) {
+			remaining->iov_base = (char*)remaining->iov_base + written;
+			remaining->iov_len -= (size_t)written;
+		}
+	}
+
+	if (close(fd) != 0 || !ok) {
+		unlink(rjd_path_get(&path_temp));
+		return RJD_RESULT("Failed to write output file");
+	}
+
+	if (rename(rjd_path_get(&path_temp), path) != 0) {
+		unlink(rjd_path_get(&path_temp));
+		return RJD_RESULT("Failed to move output file into place");
+	}
+#else
+	FILE* file = fopen(rjd_path_get(&path_temp), "wb");
+	if (!file) {
+		return RJD_RESULT("Failed to open output file path for write");
+	}
+
+	bool ok = true;
+	for (uint32_t i = 0; i < span_count; ++i) {
+		ok = ok && fwrite(spans[i].data, 1, spans[i].length, file) == spans[i].length;
+	}
+
+	if (fclose(file) != 0 || !ok) {
+		remove(rjd_path_get(&path_temp));
+		return RJD_RESULT("Failed to write output file");
+	}
+
+	// rename() won't replace an existing file here
+	remove(path);
+	if (rename(rjd_path_get(&path_temp), path) != 0) {
+		remove(rjd_path_get(&path_temp));
+		return RJD_RESULT("Failed to move output file into place");
+	}
+#endif
+
+	return RJD_RESULT_OK();
+}
+
+// Linear allocator for memory that only lives while one page is transformed. It's restarted for
+// every page and only reallocated when a page needs more than it has, or far less, so allocation is
+// a pointer bump and memory use is bounded by the largest recent page rather than the size of the site.
+struct page_arena
+{
+	struct rjd_mem_allocator* backing;
+	char* memory;
+	size_t capacity;
+	struct rjd_mem_allocator linear;
+
+	size_t high_water; // of the most recent page
+	size_t high_water_max;
+};
+
+#define PAGE_ARENA_MIN_CAPACITY (256 * 1024)
+
+// required is the most the page can possibly allocate, since a linear allocator can't grow mid-page
+GEN_INTERNAL struct rjd_mem_allocator* page_arena_begin(struct page_arena* arena, size_t required)
+{
+	// After one huge page, the pages that follow give its memory back rather than keeping it for the
+	// rest of the build
+	const bool oversized = arena->capacity > PAGE_ARENA_MIN_CAPACITY && required < arena->capacity / 8;
+	if (required > arena->capacity || oversized) {
+		// headroom so a run of slightly bigger pages doesn't reallocate every time
+		const size_t capacity = rjd_math_max_sizet(required + required / 2, PAGE_ARENA_MIN_CAPACITY);
+		if (arena->memory) {
+			rjd_mem_free(arena->memory);
+		}
+		arena->memory = rjd_mem_alloc_array_noclear(char, capacity, arena->backing);
+		arena->capacity = capacity;
+	}
+
+	arena->linear = rjd_mem_allocator_init_linear(arena->memory, arena->capacity);
+	return &arena->linear;
+}
+
+GEN_INTERNAL void page_arena_end(struct page_arena* arena)
+{
+	const struct rjd_mem_allocator_stats stats = rjd_mem_allocator_getstats(&arena->linear);
+	arena->high_water = stats.tracking.peak;
+	arena->high_water_max = rjd_math_max_sizet(arena->high_water_max, arena->high_water);
+}
+
+// --trace records a Chrome trace-event file, viewable in chrome://tracing or Perfetto. Each thread
+// records into its own buffer so recording never takes a lock. With tracing off, the buffer
+// pointers are NULL and every trace point is a single branch.
+enum trace_counter
+{
+	TRACE_COUNTER_BYTES_READ,
+	TRACE_COUNTER_BYTES_WRITTEN,
+	TRACE_COUNTER_TOKENS,
+	TRACE_COUNTER_BLOCKS,
+	TRACE_COUNTER_COUNT,
+};
+
+GEN_INTERNAL const char* TRACE_COUNTER_NAMES[] =
+{
+	"bytes read",
+	"bytes written",
+	"tokens",
+	"blocks",
+};
+RJD_STATIC_ASSERT(rjd_countof(TRACE_COUNTER_NAMES) == TRACE_COUNTER_COUNT);
+
+struct trace_event
+{
+	const char* name; // a scope name, or a TRACE_COUNTER_NAMES entry for counter samples
+	const char* detail; // optional, e.g. the file being built. Must outlive the trace.
+	double begin; // seconds since the trace started
+	double duration;
+	uint64_t counter_value;
+	bool is_counter;
+};
+
+struct trace_buffer
+{
+	struct trace* trace;
+	struct rjd_mem_allocator alloc; // each buffer's own, since it outlives the thread that filled it
+	struct trace_event* events;
+	uint64_t counters[TRACE_COUNTER_COUNT]; // running totals for this thread
+	uint32_t thread_id;
+	char thread_name[32];
+};
+
+struct trace
+{
+	struct rjd_mem_allocator* alloc;
+	struct rjd_timer epoch;
+	struct rjd_lock lock; // only guards adding buffers
+	struct trace_buffer** buffers;
+};
+
+GEN_INTERNAL void trace_init(struct trace* trace, struct rjd_mem_allocator* alloc)
+{
+	trace->alloc = alloc;
+	trace->epoch = rjd_timer_init();
+	trace->buffers = rjd_array_alloc(struct trace_buffer*, 16, alloc);
+	rjd_lock_init(&trace->lock);
+}
+
+GEN_INTERNAL void trace_free(struct trace* trace)
+{
+	for (uint32_t i = 0; i < rjd_array_count(trace->buffers); ++i) {
+		rjd_array_free(trace->buffers[i]->events);
+		rjd_mem_free(trace->buffers[i]);
+	}
+	rjd_array_free(trace->buffers);
+	rjd_lock_deinit(&trace->lock);
+}
+
+// Returns NULL if trace is NULL, so callers can pass the result straight to the other trace functions
+GEN_INTERNAL struct trace_buffer* trace_thread_begin(struct trace* trace, const char* thread_name)
+{
+	if (trace == NULL) {
+		return NULL;
+	}
+
+	rjd_lock_acquire_writer(&trace->lock);
+	struct trace_buffer* buffer = rjd_mem_alloc(struct trace_buffer, trace->alloc);
+	buffer->trace = trace;
+	buffer->alloc = rjd_mem_allocator_init_default();
+	buffer->events = rjd_array_alloc(struct trace_event, 1024, &buffer->alloc);
+	buffer->thread_id = rjd_array_count(trace->buffers) + 1;
+	snprintf(buffer->thread_name, sizeof(buffer->thread_name), "%s", thread_name);
+	rjd_array_push(trace->buffers, buffer);
+	rjd_lock_release_writer(&trace->lock);
+
+	return buffer;
+}
+
+GEN_INTERNAL double trace_now(const struct trace_buffer* buffer)
+{
+	return buffer ? rjd_timer_elapsed(&buffer->trace->epoch) : 0.0;
+}
+
+// Records a scope that began at the given trace_now() and ends now. Returns the end time so
+// back-to-back phases can chain off each other.
+GEN_INTERNAL double trace_scope(struct trace_buffer* buffer, const char* name, const char* detail, double begin)
+{
+	if (buffer == NULL) {
+		return 0.0;
+	}
+
+	const double end = trace_now(buffer);
+	struct trace_event event = {
+		.name = name,
+		.detail = detail,
+		.begin = begin,
+		.duration = end - begin,
+	};
+	rjd_array_push(buffer->events, event);
+	return end;
+}
+
+GEN_INTERNAL void trace_count(struct trace_buffer* buffer, enum trace_counter counter, uint64_t amount)
+{
+	if (buffer == NULL) {
+		return;
+	}
+
+	buffer->counters[counter] += amount;
+	struct trace_event event = {
+		.name = TRACE_COUNTER_NAMES[counter],
+		.begin = trace_now(buffer),
+		.counter_value = buffer->counters[counter],
+		.is_counter = true,
+	};
+	rjd_array_push(buffer->events, event);
+}
+
+GEN_INTERNAL void append_json_string(struct rjd_strbuf* out, const char* str)
+{
+	rjd_strbuf_append(out, "\"");
+	for (const char* next = str; *next; ++next) {
+		if (*next == '"' || *next == '\\') {
+			rjd_strbuf_append(out, "\\%c", *next);
+		} else if ((uint8_t)*next < 0x20) {
+			rjd_strbuf_append(out, "\\u%04x", (unsigned)*next);
+		} else {
+			rjd_strbuf_appendl(out, next, 1);
+		}
+	}
+	rjd_strbuf_append(out, "\"");
+}
+
+// Call once every thread that recorded into the trace has finished
+GEN_INTERNAL struct rjd_result trace_write(const struct trace* trace, const char* path)
+{
+	struct rjd_strbuf out = rjd_strbuf_init(trace->alloc);
+	rjd_strbuf_append(&out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	bool first = true;
+	for (uint32_t i = 0; i < rjd_array_count(trace->buffers); ++i) {
+		const struct trace_buffer* buffer = trace->buffers[i];
+
+		rjd_strbuf_append(&out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", 
+			first ? "" : ",\n", buffer->thread_id);
+		append_json_string(&out, buffer->thread_name);
+		rjd_strbuf_append(&out, "}}");
+		first = false;
+
+		for (uint32_t j = 0; j < rjd_array_count(buffer->events); ++j) {
+			const struct trace_event* event = buffer->events + j;
+			rjd_strbuf_append(&out, ",\n{\"name\":");
+			append_json_string(&out, event->name);
+
+			if (event->is_counter) {
+				// Counters are per process in the viewer, so each thread is its own series
+				rjd_strbuf_append(&out, ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{", buffer->thread_id, event->begin * 1e6);
+				append_json_string(&out, buffer->thread_name);
+				rjd_strbuf_append(&out, ":%" PRIu64 "}}", event->counter_value);
+			} else {
+				rjd_strbuf_append(&out, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", 
+					buffer->thread_id, event->begin * 1e6, event->duration * 1e6);
+				if (event->detail) {
+					rjd_strbuf_append(&out, ",\"args\":{\"file\":");
+					append_json_string(&out, event->detail);
+					rjd_strbuf_append(&out, "}");
+				}
+				rjd_strbuf_append(&out, "}");
+			}
+		}
+	}
+	rjd_strbuf_append(&out, "\n]}\n");
+
+	const struct output_span span = { rjd_strbuf_str(&out), out.length };
+	struct rjd_result result = write_file_atomic(path, &span, 1);
+	rjd_strbuf_free(&out);
+	return result;
+}
+
+// Time spent in each stage of transforming markdown, summed over every page built with a scratch
+struct transform_timings
+{
+	uint64_t pages;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	double read;
+	double tokenize;
+	double parse; // markdown into a document
+	double render; // document into html
+	double emit; // page template around the body
+	double write;
+	double compress; // sidecars of pages and assets
+	uint64_t minified_bytes; // whitespace --minify left out of pages and stylesheets
+	uint64_t critical_css_bytes; // css --critical-css inlined into pages
+	uint64_t rewritten_files; // outputs written by write_output_file()
+	uint64_t unchanged_files; // outputs write_output_file() left alone since they already matched
+};
+
+GEN_INTERNAL void transform_timings_add(struct transform_timings* sum, const struct transform_timings* timings)
+{
+	sum->pages += timings->pages;
+	sum->bytes_in += timings->bytes_in;
+	sum->bytes_out += timings->bytes_out;
+	sum->read += timings->read;
+	sum->tokenize += timings->tokenize;
+	sum->parse += timings->parse;
+	sum->render += timings->render;
+	sum->emit += timings->emit;
+	sum->write += timings->write;
+	sum->compress += timings->compress;
+	sum->minified_bytes += timings->minified_bytes;
+	sum->critical_css_bytes += timings->critical_css_bytes;
+	sum->rewritten_files += timings->rewritten_files;
+	sum->unchanged_files += timings->unchanged_files;
+}
+
+// True if the file at path already holds exactly the spans. Sizes are compared first, so most
+// changed outputs only cost a stat, and only a file of the same size is mapped and compared.
+GEN_INTERNAL bool output_file_matches(const char* path, const struct output_span* spans, uint32_t span_count)
+{
+	size_t total = 0;
+	for (uint32_t i = 0; i < span_count; ++i) {
+		total += spans[i].length;
+	}
+
+	struct stat info;
+	if (stat(path, &info) != 0 || (info.st_mode & S_IFMT) != S_IFREG || (uint64_t)info.st_size != total) {
+		return false;
+	}
+	if (total == 0) {
+		return true;
+	}
+
+	bool matches = false;
+#if GEN_POSIX
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	const char* existing = mmap(NULL, total, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (existing == MAP_FAILED) {
+		return false;
+	}
+
+	matches = true;
+	size_t offset = 0;
+	for (uint32_t i = 0; matches && i < span_count; offset += spans[i++].length) {
+		matches = memcmp(existing + offset, spans[i].data, spans[i].length) == 0;
+	}
+	munmap((void*)existing, total);
+#else
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	matches = true;
+	char chunk[16 * 1024];
+	for (uint32_t i = 0; matches && i < span_count; ++i) {
+		for (size_t offset = 0; matches && offset < spans[i].length; offset += sizeof(chunk)) {
+			const size_t length = rjd_math_min_sizet(sizeof(chunk), spans[i].length - offset);
+			matches = fread(chunk, 1, length, file) == length && memcmp(chunk, spans[i].data + offset, length) == 0;
+		}
+	}
+	fclose(file);
+#endif
+	return matches;
+}
+
+// Writes the spans with write_file_atomic() unless the file already holds them, so an output's
+// mtime only changes along with its contents and deploys that sync by mtime only upload real changes.
+GEN_INTERNAL struct rjd_result write_output_file(const char* path, const struct output_span* spans, uint32_t span_count, struct transform_timings* timings)
+{
+	if (output_file_matches(path, spans, span_count)) {
+		timings->unchanged_files += 1;
+		return RJD_RESULT_OK();
+	}
+
+	struct rjd_result result = write_file_atomic(path, spans, span_count);
+	if (rjd_result_isok(result)) {
+		timings->rewritten_files += 1;
+	}
+	return result;
+}
+
+// Buffers a thread reuses for every file it processes
+struct transform_scratch
+{
+	struct rjd_mem_allocator* alloc;
+	char* read_buffer; // rjd_array sized to the largest small file read so far
+	struct rjd_strbuf page;
+	struct rjd_strbuf html; // see render_state
+	struct rjd_strbuf style; // the page's --critical-css rules
+	struct page_arena arena; // tokens
+	struct page_arena doc_arena; // the parsed document, sized once the token count is known
+	struct transform_timings timings;
+	struct trace_buffer* trace; // NULL unless tracing
+
+	// Compressors are kept from file to file since setting one up allocates its whole window
+	char* compress_buffer; // rjd_array
+#if GEN_GZIP
+	z_stream gzip;
+	int gzip_level; // 0 until gzip is set up
+#endif
+#if GEN_ZSTD
+	ZSTD_CCtx* zstd;
+#endif
+};
+
+GEN_INTERNAL struct transform_scratch transform_scratch_init(struct rjd_mem_allocator* alloc)
+{
+	struct transform_scratch scratch = {
+		.alloc = alloc,
+		.read_buffer = rjd_array_alloc(char, 64 * 1024, alloc),
+		.page = rjd_strbuf_init(alloc),
+		.html = rjd_strbuf_init(alloc),
+		.style = rjd_strbuf_init(alloc),
+		.arena = { .backing = alloc },
+		.doc_arena = { .backing = alloc },
+		.compress_buffer = rjd_array_alloc(char, 64 * 1024, alloc),
+	};
+	return scratch;
+}
+
+GEN_INTERNAL void transform_scratch_free(struct transform_scratch* scratch)
+{
+	rjd_array_free(scratch->read_buffer);
+	rjd_strbuf_free(&scratch->page);
+	rjd_strbuf_free(&scratch->html);
+	rjd_strbuf_free(&scratch->style);
+	if (scratch->arena.memory) {
+		rjd_mem_free(scratch->arena.memory);
+	}
+	if (scratch->doc_arena.memory) {
+		rjd_mem_free(scratch->doc_arena.memory);
+	}
+	rjd_array_free(scratch->compress_buffer);
+#if GEN_GZIP
+	if (scratch->gzip_level) {
+		deflateEnd(&scratch->gzip);
+	}
+#endif
+#if GEN_ZSTD
+	ZSTD_freeCCtx(scratch->zstd);
+#endif
+}
+
+// Files at least this big are memory mapped. Smaller ones are cheaper to read into the scratch buffer.
+#define SOURCE_FILE_MMAP_THRESHOLD (64 * 1024)
+
+// A read-only view of a file's contents, either mapped or in the scratch read buffer. Only valid until
+// source_file_close() or the next source_file_open() with the same scratch.
+struct source_file
+{
+	const char* contents;
+	size_t size;
+	void* mapping;
+};
+
+GEN_INTERNAL struct rjd_result source_file_open(struct source_file* out, const char* path, struct transform_scratch* scratch)
+{
+	*out = (struct source_file){0};
+
+#if GEN_POSIX
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return RJD_RESULT("Failed to open the path for reading");
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		return RJD_RESULT("Failed to stat the path for reading");
+	}
+
+	out->size = (size_t)info.st_size;
+
+	if (out->size >= SOURCE_FILE_MMAP_THRESHOLD) {
+		void* mapping = mmap(NULL, out->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) {
+			return RJD_RESULT("Failed to map the path for reading");
+		}
+		madvise(mapping, out->size, MADV_SEQUENTIAL);
+
+		out->mapping = mapping;
+		out->contents = mapping;
+		return RJD_RESULT_OK();
+	}
+
+	rjd_array_resize(scratch->read_buffer, (uint32_t)out->size);
+
+	size_t total = 0;
+	while (total < out->size) {
+		ssize_t count = read(fd, scratch->read_buffer + total, out->size - total);
+		if (count <= 0) {
+			break;
+		}
+		total += (size_t)count;
+	}
+	close(fd);
+
+	if (total != out->size) {
+		return RJD_RESULT("Failed to read the whole file");
+	}
+#else
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		return RJD_RESULT("Failed to open the path for reading");
+	}
+
+	fseek(file, 0, SEEK_END);
+	out->size = (size_t)ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	rjd_array_resize(scratch->read_buffer, (uint32_t)out->size);
+	const size_t total = fread(scratch->read_buffer, 1, out->size, file);
+	fclose(file);
+
+	if (total != out->size) {
+		return RJD_RESULT("Failed to read the whole file");
+	}
+#endif
+
+	out->contents = scratch->read_buffer;
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL void source_file_close(struct source_file* file)
+{
+#if GEN_POSIX
+	if (file->mapping) {
+		munmap(file->mapping, file->size);
+	}
+#endif
+	*file = (struct source_file){0};
+}
+
+// A static server can send a precompressed copy sitting next to a file rather than compressing the
+// file on every request. Outputs get one of these sidecars per format that's on, compressed from the
+// same buffers the output was written from.
+enum compress_format
+{
+	COMPRESS_FORMAT_GZIP,
+	COMPRESS_FORMAT_ZSTD,
+	COMPRESS_FORMAT_COUNT,
+};
+
+GEN_INTERNAL const char* COMPRESS_FORMAT_NAMES[] =
+{
+	"gzip",
+	"zstd",
+};
+RJD_STATIC_ASSERT(rjd_countof(COMPRESS_FORMAT_NAMES) == COMPRESS_FORMAT_COUNT);
+
+GEN_INTERNAL const char* COMPRESS_FORMAT_EXTENSIONS[] =
+{
+	".gz",
+	".zst",
+};
+RJD_STATIC_ASSERT(rjd_countof(COMPRESS_FORMAT_EXTENSIONS) == COMPRESS_FORMAT_COUNT);
+
+GEN_INTERNAL const bool COMPRESS_FORMAT_AVAILABLE[] =
+{
+	GEN_GZIP,
+	GEN_ZSTD,
+};
+RJD_STATIC_ASSERT(rjd_countof(COMPRESS_FORMAT_AVAILABLE) == COMPRESS_FORMAT_COUNT);
+
+GEN_INTERNAL const int COMPRESS_FORMAT_MAX_LEVELS[] =
+{
+	9,
+	19, // higher levels need zstd's --ultra window sizes
+};
+RJD_STATIC_ASSERT(rjd_countof(COMPRESS_FORMAT_MAX_LEVELS) == COMPRESS_FORMAT_COUNT);
+
+#define COMPRESS_FORMAT_ALL_BITS ((1u << COMPRESS_FORMAT_COUNT) - 1)
+
+struct compress_settings
+{
+	int levels[COMPRESS_FORMAT_COUNT]; // 0 if the format is off
+};
+
+// Assets that are already compressed (images, fonts, archives) wouldn't shrink, so only these get sidecars
+GEN_INTERNAL const char* COMPRESSIBLE_ASSET_EXTENSIONS[] =
+{
+	".css", ".js", ".mjs", ".json", ".map", ".svg", ".xml", ".txt", ".html", ".wasm",
+};
+
+GEN_INTERNAL bool compress_settings_any(const struct compress_settings* settings)
+{
+	for (uint32_t format = 0; format < COMPRESS_FORMAT_COUNT; ++format) {
+		if (settings->levels[format] > 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+GEN_INTERNAL bool is_compressible_asset(const char* path)
+{
+	for (uint32_t i = 0; i < rjd_countof(COMPRESSIBLE_ASSET_EXTENSIONS); ++i) {
+		if (rjd_path_str_endswith(path, COMPRESSIBLE_ASSET_EXTENSIONS[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// The compressors write the spans as one stream into the scratch's compress buffer, returning the
+// compressed size or 0 if compression failed.
+#if GEN_GZIP
+GEN_INTERNAL size_t compress_gzip(const struct output_span* spans, uint32_t span_count, size_t total, int level, struct transform_scratch* scratch)
+{
+	z_stream* z = &scratch->gzip;
+	if (scratch->gzip_level == 0) {
+		memset(z, 0, sizeof(*z));
+		// 16 + the window bits makes deflate write a gzip header and trailer instead of zlib's
+		if (deflateInit2(z, level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			return 0;
+		}
+		scratch->gzip_level = level;
+	} else {
+		deflateReset(z);
+		if (scratch->gzip_level != level && deflateParams(z, level, Z_DEFAULT_STRATEGY) == Z_OK) {
+			scratch->gzip_level = level;
+		}
+	}
+
+	const uLong bound = deflateBound(z, (uLong)total);
+	rjd_array_resize(scratch->compress_buffer, (uint32_t)bound);
+	z->next_out = (Bytef*)scratch->compress_buffer;
+	z->avail_out = (uInt)bound;
+
+	int status = Z_OK;
+	for (uint32_t i = 0; i < span_count; ++i) {
+		z->next_in = (Bytef*)spans[i].data;
+		z->avail_in = (uInt)spans[i].length;
+		status = deflate(z, i + 1 < span_count ? Z_NO_FLUSH : Z_FINISH);
+	}
+
+	return status == Z_STREAM_END ? (size_t)z->total_out : 0;
+}
+#endif
+
+#if GEN_ZSTD
+GEN_INTERNAL size_t compress_zstd(const struct output_span* spans, uint32_t span_count, size_t total, int level, struct transform_scratch* scratch)
+{
+	if (scratch->zstd == NULL) {
+		scratch->zstd = ZSTD_createCCtx();
+		if (scratch->zstd == NULL) {
+			return 0;
+		}
+	}
+
+	ZSTD_CCtx* cctx = scratch->zstd;
+	ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+	ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+	ZSTD_CCtx_setPledgedSrcSize(cctx, total);
+
+	const size_t bound = ZSTD_compressBound(total);
+	rjd_array_resize(scratch->compress_buffer, (uint32_t)bound);
+	ZSTD_outBuffer output = { scratch->compress_buffer, bound, 0 };
+
+	for (uint32_t i = 0; i < span_count; ++i) {
+		ZSTD_inBuffer input = { spans[i].data, spans[i].length, 0 };
+		const ZSTD_EndDirective mode = i + 1 < span_count ? ZSTD_e_continue : ZSTD_e_end;
+		for (;;) {
+			const size_t remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+			if (ZSTD_isError(remaining)) {
+				return 0;
+			}
+			if (mode == ZSTD_e_end ? remaining == 0 : input.pos == input.size) {
+				break;
+			}
+			if (output.pos == output.size) {
+				return 0;
+			}
+		}
+	}
+
+	return output.pos;
+}
+#endif
+
+// Writes a sidecar of the spans next to path for each format that's on. A sidecar that wouldn't be
+// smaller than the file is skipped. sidecars has a bit per format: on input the sidecars an earlier
+// build wrote, which are deleted if they aren't rewritten so they can't go stale, and on output the
+// ones written now.
+GEN_INTERNAL struct rjd_result write_compressed_sidecars(const char* path, const struct output_span* spans, uint32_t span_count,
+	const struct compress_settings* settings, uint8_t* sidecars, struct transform_scratch* scratch)
+{
+	if (!compress_settings_any(settings) && *sidecars == 0) {
+		return RJD_RESULT_OK();
+	}
+
+	struct rjd_timer timer = rjd_timer_init();
+	const double trace_begin = trace_now(scratch->trace);
+
+	size_t total = 0;
+	for (uint32_t i = 0; i < span_count; ++i) {
+		total += spans[i].length;
+	}
+
+	struct rjd_result result = RJD_RESULT_OK();
+	uint8_t written = 0;
+	for (uint32_t format = 0; format < COMPRESS_FORMAT_COUNT; ++format) {
+		const int level = settings->levels[format];
+		size_t compressed_size = 0;
+		if (level > 0) {
+			switch ((enum compress_format)format)
+			{
+				case COMPRESS_FORMAT_GZIP:
+				#if GEN_GZIP
+					compressed_size = compress_gzip(spans, span_count, total, level, scratch);
+				#endif
+					break;
+				case COMPRESS_FORMAT_ZSTD:
+				#if GEN_ZSTD
+					compressed_size = compress_zstd(spans, span_count, total, level, scratch);
+				#endif
+					break;
+				case COMPRESS_FORMAT_COUNT:
+					break;
+			}
+
+			if (compressed_size == 0) {
+				result = RJD_RESULT("Failed to compress output");
+			}
+		}
+
+		struct rjd_path path_sidecar = rjd_path_init_with(path);
+		rjd_path_append(&path_sidecar, COMPRESS_FORMAT_EXTENSIONS[format]);
+
+		if (compressed_size > 0 && compressed_size < total) {
+			const struct output_span span = { scratch->compress_buffer, compressed_size };
+			struct rjd_result write_result = write_output_file(rjd_path_get(&path_sidecar), &span, 1, &scratch->timings);
+			if (rjd_result_isok(write_result)) {
+				written |= (uint8_t)(1u << format);
+				trace_count(scratch->trace, TRACE_COUNTER_BYTES_WRITTEN, compressed_size);
+			} else {
+				result = write_result;
+			}
+		}
+
+		if ((*sidecars & (1u << format)) && !(written & (1u << format))) {
+			remove(rjd_path_get(&path_sidecar));
+		}
+	}
+
+	*sidecars = written;
+	scratch->timings.compress += rjd_timer_elapsed(&timer);
+	trace_scope(scratch->trace, "compress", path, trace_begin);
+	return result;
+}
+
+// Strips comments and the whitespace CSS doesn't need. Strings are copied as-is, and whitespace is
+// only dropped next to punctuation that can't need it, so descendant selectors and calc() keep their
+// spaces. The last ; in a block goes too.
+GEN_INTERNAL void minify_css(const char* css, size_t length, struct rjd_strbuf* out)
+{
+	#define GEN_CSS_IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r' || (c) == '\f')
+	#define GEN_CSS_SPACE_BEFORE_UNNEEDED(c) ((c) == '{' || (c) == '}' || (c) == ';' || (c) == ',' || (c) == '>')
+	#define GEN_CSS_SPACE_AFTER_UNNEEDED(c) (GEN_CSS_SPACE_BEFORE_UNNEEDED(c) || (c) == ':')
+
+	char last = '{'; // nothing needs a space at the very start
+	bool pending_space = false;
+	bool pending_semicolon = false;
+
+	size_t i = 0;
+	while (i < length) {
+		const char c = css[i];
+		if (c == '/' && i + 1 < length && css[i + 1] == '*') {
+			i += 2;
+			while (i < length && !(css[i] == '*' && i + 1 < length && css[i + 1] == '/')) {
+				++i;
+			}
+			i = rjd_math_min_sizet(i + 2, length);
+			pending_space = true; // a comment separates tokens like whitespace does
+			continue;
+		}
+		if (GEN_CSS_IS_SPACE(c)) {
+			pending_space = true;
+			++i;
+			continue;
+		}
+
+		if (pending_semicolon && c != '}') {
+			rjd_strbuf_appendl(out, ";", 1);
+		}
+		if (c == ';') {
+			// held back until the next character shows whether it closes the block
+			pending_semicolon = true;
+			pending_space = false;
+			last = c;
+			++i;
+			continue;
+		}
+		pending_semicolon = false;
+
+		if (pending_space && !GEN_CSS_SPACE_AFTER_UNNEEDED(last) && !GEN_CSS_SPACE_BEFORE_UNNEEDED(c)) {
+			rjd_strbuf_appendl(out, " ", 1);
+		}
+		pending_space = false;
+
+		if (c == '"' || c == '\'') {
+			size_t end = i + 1;
+			while (end < length && css[end] != c && css[end] != '\n') {
+				end += css[end] == '\\' ? 2 : 1;
+			}
+			end = rjd_math_min_sizet(end + 1, length);
+			rjd_strbuf_appendl(out, css + i, (uint32_t)(end - i));
+			i = end;
+		} else {
+			rjd_strbuf_appendl(out, &c, 1);
+			++i;
+		}
+		last = c;
+	}
+
+	if (pending_semicolon) {
+		rjd_strbuf_appendl(out, ";", 1);
+	}
+
+	#undef GEN_CSS_IS_SPACE
+	#undef GEN_CSS_SPACE_BEFORE_UNNEEDED
+	#undef GEN_CSS_SPACE_AFTER_UNNEEDED
+}
+
+// Logs the bytes --minify saved on a file of minified_length
+GEN_INTERNAL void log_minified(struct rjd_strbuf* log, uint32_t saved, size_t minified_length)
+{
+	const size_t original_length = minified_length + saved;
+	rjd_strbuf_append(log, "\tminified %u bytes (%.1f%%)\n", saved, original_length ? saved * 100.0 / original_length : 0.0);
+}
+
+// --critical-css inlines the rules from the template's stylesheets that a page could use into a
+// <style> in its head, and the full stylesheets load without blocking. The stylesheets are parsed
+// once into rules, each selector reduced to the tag, class and id names it needs. A page keeps a
+// rule if all the names of one of its selectors are somewhere in the page. Combinators and
+// pseudo-classes aren't checked, so a page can get rules it doesn't use, but never misses one.
+#define CRITICAL_CSS_MAX_NAMES 512
+#define CRITICAL_CSS_MAX_GROUP_DEPTH 16
+
+// A bit per name in critical_css::names
+struct css_names
+{
+	uint64_t bits[CRITICAL_CSS_MAX_NAMES / 64];
+};
+
+enum css_rule_type
+{
+	CSS_RULE_STYLE, // selectors and a declaration block
+	CSS_RULE_ALWAYS, // at-rules without selectors, like @font-face and @keyframes, which every page keeps
+	CSS_RULE_GROUP, // a conditional group like @media, only kept if one of its rules is
+	CSS_RULE_DEFERRED, // never inlined, like @import or rules with urls relative to their stylesheet
+};
+
+struct css_rule
+{
+	enum css_rule_type type;
+	uint32_t offset; // into the css text
+	uint32_t length; // the whole rule. group: only the prelude up to and including the {
+	uint32_t first_selector; // style: range in critical_css::selectors
+	uint32_t selector_count;
+	uint32_t end; // group: index of the rule after its last one
+};
+
+struct critical_css
+{
+	struct rjd_strbuf text; // the stylesheets, minified
+	struct css_rule* rules; // rjd_array
+	struct css_names* selectors; // rjd_array, the names each selector needs
+	struct rjd_dict names; // hash of a name like "pre", ".quote" or "#main" -> its bit+1
+	uint32_t name_count;
+	struct css_names template_names; // in the template's html, so used by every page
+	uint64_t hash;
+};
+
+// Tag names are matched case-insensitively, classes and ids exactly
+GEN_INTERNAL uint64_t css_name_hash(char prefix, const char* name, uint32_t length)
+{
+	char key[256];
+	length = rjd_math_min_u32(length, sizeof(key) - 1);
+	key[0] = prefix;
+	for (uint32_t i = 0; i < length; ++i) {
+		key[i + 1] = prefix ? name[i] : (char)tolower((unsigned char)name[i]);
+	}
+	return rjd_hash64_data((const uint8_t*)key, length + 1).value;
+}
+
+// Past the end of the css identifier at begin
+GEN_INTERNAL uint32_t css_ident_end(const char* css, uint32_t length, uint32_t begin)
+{
+	uint32_t end = begin;
+	while (end < length && (isalnum((unsigned char)css[end]) || css[end] == '-' || css[end] == '_' || (unsigned char)css[end] >= 0x80)) {
+		++end;
+	}
+	return end;
+}
+
+// Past the end of the string, or the matching ) or ], starting at begin
+GEN_INTERNAL uint32_t css_skip_nested(const char* css, uint32_t length, uint32_t begin)
+{
+	const char open = css[begin];
+	const char close = open == '(' ? ')' : open == '[' ? ']' : open;
+	uint32_t depth = 0;
+	for (uint32_t i = begin; i < length; ++i) {
+		if (open == '"' || open == '\'') {
+			if (i > begin && css[i] == '\\') {
+				++i;
+			} else if (i > begin && css[i] == close) {
+				return i + 1;
+			}
+		} else if (css[i] == '"' || css[i] == '\'') {
+			i = css_skip_nested(css, length, i) - 1;
+		} else if (css[i] == open) {
+			++depth;
+		} else if (css[i] == close && --depth == 0) {
+			return i + 1;
+		}
+	}
+	return length;
+}
+
+// Index of the first of the characters outside of strings and brackets, or length
+GEN_INTERNAL uint32_t css_find(const char* css, uint32_t length, uint32_t begin, const char* chars)
+{
+	uint32_t i = begin;
+	while (i < length && !(css[i] && strchr(chars, css[i]))) {
+		const bool nested = css[i] == '"' || css[i] == '\'' || css[i] == '(' || css[i] == '[';
+		i = nested ? css_skip_nested(css, length, i) : i + 1;
+	}
+	return i;
+}
+
+// Past the } matching the { at begin
+GEN_INTERNAL uint32_t css_block_end(const char* css, uint32_t length, uint32_t begin)
+{
+	uint32_t depth = 0;
+	for (uint32_t i = begin; i < length; ++i) {
+		i = css_find(css, length, i, "{}");
+		if (i == length) {
+			break;
+		}
+		if (css[i] == '{') {
+			++depth;
+		} else if (--depth == 0) {
+			return i + 1;
+		}
+	}
+	return length;
+}
+
+// Sets the name's bit. Names no selector needs don't have one, so they're ignored.
+GEN_INTERNAL void css_names_set(const struct critical_css* critical, char prefix, const char* name, uint32_t length, struct css_names* names)
+{
+	const struct rjd_hash64 hash = { css_name_hash(prefix, name, length) };
+	const uint32_t bit = (uint32_t)(uintptr_t)rjd_dict_get(&critical->names, hash);
+	if (bit > 0) {
+		names->bits[(bit - 1) / 64] |= 1ull << ((bit - 1) % 64);
+	}
+}
+
+// Gives the name a bit if it doesn't have one yet, and sets it. A selector needing a name past the
+// limit just matches more pages.
+GEN_INTERNAL void css_names_add(struct critical_css* critical, char prefix, const char* name, uint32_t length, struct css_names* names)
+{
+	const struct rjd_hash64 hash = { css_name_hash(prefix, name, length) };
+	if (rjd_dict_get(&critical->names, hash) == NULL && critical->name_count < CRITICAL_CSS_MAX_NAMES) {
+		rjd_dict_insert(&critical->names, hash, (void*)(uintptr_t)++critical->name_count);
+	}
+	css_names_set(critical, prefix, name, length, names);
+}
+
+// Pushes the names each of the comma separated selectors in [begin, end) needs. Anything in
+// brackets, like :not(.a) or [type=text], is skipped since it doesn't have to be in the page.
+GEN_INTERNAL void css_parse_selectors(struct critical_css* critical, uint32_t begin, uint32_t end, struct css_rule* rule)
+{
+	const char* css = rjd_strbuf_str(&critical->text);
+	rule->first_selector = rjd_array_count(critical->selectors);
+
+	struct css_names names = {0};
+	uint32_t i = begin;
+	while (i <= end) {
+		const char c = i < end ? css[i] : ',';
+		if (c == ',') {
+			rjd_array_push(critical->selectors, names);
+			memset(&names, 0, sizeof(names));
+			++i;
+		} else if (c == '.' || c == '#') {
+			const uint32_t name_end = css_ident_end(css, end, i + 1);
+			css_names_add(critical, c, css + i + 1, name_end - i - 1, &names);
+			i = rjd_math_max_u32(name_end, i + 1);
+		} else if (c == ':') {
+			while (i < end && css[i] == ':') {
+				++i;
+			}
+			i = css_ident_end(css, end, i);
+		} else if (c == '(' || c == '[' || c == '"' || c == '\'') {
+			i = css_skip_nested(css, end, i);
+		} else if (isalpha((unsigned char)c) || c == '_' || c == '-') {
+			const uint32_t name_end = css_ident_end(css, end, i);
+			css_names_add(critical, '\0', css + i, name_end - i, &names);
+			i = name_end;
+		} else {
+			++i;
+		}
+	}
+	rule->selector_count = rjd_array_count(critical->selectors) - rule->first_selector;
+}
+
+// Whether a url() in [begin, end) is relative to the stylesheet, so it would break once inlined
+GEN_INTERNAL bool css_has_relative_url(const char* css, uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i + 4 < end; ++i) {
+		if (strncmp(css + i, "url(", 4)) {
+			continue;
+		}
+		uint32_t url = i + 4;
+		while (url < end && (css[url] == '"' || css[url] == '\'' || isspace((unsigned char)css[url]))) {
+			++url;
+		}
+		uint32_t url_end = url;
+		while (url_end < end && css[url_end] != ')' && css[url_end] != ':') {
+			++url_end;
+		}
+		const bool is_absolute = (url < end && css[url] == '/') || (url_end < end && css[url_end] == ':');
+		if (!is_absolute) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Groups nested past CRITICAL_CSS_MAX_GROUP_DEPTH are kept whole
+GEN_INTERNAL void css_parse_rules(struct critical_css* critical, uint32_t begin, uint32_t end, uint32_t depth)
+{
+	const char* css = rjd_strbuf_str(&critical->text);
+	uint32_t i = begin;
+	while (i < end) {
+		if (css[i] == ';' || css[i] == '}' || isspace((unsigned char)css[i])) {
+			++i;
+			continue;
+		}
+
+		const uint32_t prelude_end = css_find(css, end, i, "{;");
+		const uint32_t rule_end = prelude_end < end && css[prelude_end] == '{' ? css_block_end(css, end, prelude_end) : rjd_math_min_u32(prelude_end + 1, end);
+		struct css_rule rule = { .type = CSS_RULE_ALWAYS, .offset = i, .length = rule_end - i };
+
+		const bool is_at_rule = css[i] == '@';
+		const uint32_t at_name_end = css_ident_end(css, end, i + 1);
+		const char* at_name = css + i + 1;
+		const uint32_t at_name_length = at_name_end - i - 1;
+		const bool is_group = is_at_rule && depth < CRITICAL_CSS_MAX_GROUP_DEPTH && prelude_end < end && css[prelude_end] == '{' && 
+			((at_name_length == 5 && !strncmp(at_name, "media", 5)) || 
+			(at_name_length == 8 && !strncmp(at_name, "supports", 8)) || 
+			(at_name_length == 9 && !strncmp(at_name, "container", 9)) || 
+			(at_name_length == 5 && !strncmp(at_name, "layer", 5)));
+
+		if (is_group) {
+			rule.type = CSS_RULE_GROUP;
+			rule.length = prelude_end + 1 - i;
+			const uint32_t group = rjd_array_count(critical->rules);
+			rjd_array_push(critical->rules, rule);
+			css_parse_rules(critical, prelude_end + 1, rule_end - 1, depth + 1);
+			critical->rules[group].end = rjd_array_count(critical->rules);
+		} else {
+			const bool is_deferred = css_has_relative_url(css, i, rule_end) || (is_at_rule && 
+				((at_name_length == 6 && !strncmp(at_name, "import", 6)) || (at_name_length == 7 && !strncmp(at_name, "charset", 7))));
+			if (is_deferred) {
+				rule.type = CSS_RULE_DEFERRED;
+			} else if (!is_at_rule && prelude_end < end && css[prelude_end] == '{') {
+				rule.type = CSS_RULE_STYLE;
+				css_parse_selectors(critical, i, prelude_end, &rule);
+			}
+			rjd_array_push(critical->rules, rule);
+		}
+		i = rule_end;
+	}
+}
+
+// Sets the bits of the tags, classes and ids in the html
+GEN_INTERNAL void critical_css_collect(const struct critical_css* critical, const char* html, uint32_t length, struct css_names* names)
+{
+	for (const char* next = memchr(html, '<', length); next; next = memchr(next + 1, '<', length - (next + 1 - html))) {
+		const uint32_t tag = (uint32_t)(next - html);
+		if (tag + 1 >= length || !isalpha((unsigned char)html[tag + 1])) {
+			continue;
+		}
+
+		const uint32_t name_end = css_ident_end(html, length, tag + 1);
+		css_names_set(critical, '\0', html + tag + 1, name_end - tag - 1, names);
+
+		const uint32_t tag_end = rjd_math_min_u32(find_tag_end(html, length, tag) + 1, length);
+		const char* value = NULL;
+		uint32_t value_length = 0;
+		if (find_html_attribute(html + tag, tag_end - tag, "id", &value, &value_length)) {
+			css_names_set(critical, '#', value, value_length, names);
+		}
+		if (find_html_attribute(html + tag, tag_end - tag, "class", &value, &value_length)) {
+			for (uint32_t i = 0; i < value_length;) {
+				uint32_t class_end = i;
+				while (class_end < value_length && !isspace((unsigned char)value[class_end])) {
+					++class_end;
+				}
+				if (class_end > i) {
+					css_names_set(critical, '.', value + i, class_end - i, names);
+				}
+				i = class_end + 1;
+			}
+		}
+		next = html + tag_end - 1;
+	}
+}
+
+// Reads and parses the template's stylesheets from the source folder, and points the template at
+// them. Pages are rebuilt when the stylesheets change since they're part of the template hash.
+GEN_INTERNAL struct rjd_result critical_css_load(struct critical_css* critical, struct page_template* template, const char* path_source, struct rjd_mem_allocator* alloc)
+{
+	*critical = (struct critical_css) {
+		.text = rjd_strbuf_init(alloc),
+		.rules = rjd_array_alloc(struct css_rule, 256, alloc),
+		.selectors = rjd_array_alloc(struct css_names, 256, alloc),
+		.names = rjd_dict_init(alloc, 256),
+	};
+
+	for (uint32_t i = 0; i < rjd_array_count(template->stylesheets); ++i) {
+		struct rjd_path path = rjd_path_init_with(path_source);
+		rjd_path_join_str(&path, rjd_path_get(template->stylesheets + i));
+
+		char* contents = NULL;
+		struct rjd_result result = rjd_fio_read(rjd_path_get(&path), &contents, alloc);
+		if (!rjd_result_isok(result)) {
+			return result;
+		}
+		minify_css(contents, rjd_array_count(contents), &critical->text);
+		rjd_array_free(contents);
+	}
+
+	css_parse_rules(critical, 0, critical->text.length, 0);
+	critical_css_collect(critical, template->text, rjd_array_count(template->text), &critical->template_names);
+
+	critical->hash = rjd_hash64_data((const uint8_t*)rjd_strbuf_str(&critical->text), critical->text.length).value;
+	const uint64_t key[] = { template->hash, critical->hash };
+	template->hash = rjd_hash64_data((const uint8_t*)key, sizeof(key)).value;
+	template->critical_css = critical;
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL void critical_css_free(struct critical_css* critical)
+{
+	rjd_strbuf_free(&critical->text);
+	rjd_array_free(critical->rules);
+	rjd_array_free(critical->selectors);
+	rjd_dict_free(&critical->names);
+}
+
+GEN_INTERNAL bool css_rule_matches(const struct critical_css* critical, const struct css_rule* rule, const struct css_names* names)
+{
+	if (rule->type != CSS_RULE_STYLE) {
+		return rule->type == CSS_RULE_ALWAYS;
+	}
+
+	for (uint32_t i = rule->first_selector; i < rule->first_selector + rule->selector_count; ++i) {
+		bool matches = true;
+		for (uint32_t word = 0; word < rjd_countof(names->bits) && matches; ++word) {
+			matches = (critical->selectors[i].bits[word] & ~names->bits[word]) == 0;
+		}
+		if (matches) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Appends the rules in [begin, end) that match. A group is only appended if one of its rules is.
+GEN_INTERNAL void css_append_rules(const struct critical_css* critical, uint32_t begin, uint32_t end, const struct css_names* names, struct rjd_strbuf* out)
+{
+	const char* css = rjd_strbuf_str(&critical->text);
+	for (uint32_t i = begin; i < end; ++i) {
+		const struct css_rule* rule = critical->rules + i;
+		if (rule->type == CSS_RULE_GROUP) {
+			bool has_match = false;
+			for (uint32_t child = i + 1; child < rule->end && !has_match; ++child) {
+				has_match = css_rule_matches(critical, critical->rules + child, names);
+			}
+			if (has_match) {
+				rjd_strbuf_appendl(out, css + rule->offset, rule->length);
+				css_append_rules(critical, i + 1, rule->end, names, out);
+				rjd_strbuf_appendl(out, "}", 1);
+			}
+			i = rule->end - 1;
+		} else if (css_rule_matches(critical, rule, names)) {
+			rjd_strbuf_appendl(out, css + rule->offset, rule->length);
+		}
+	}
+}
+
+// Replaces out with the rules a page with the body html can use
+GEN_INTERNAL void critical_css_select(const struct critical_css* critical, const char* html, uint32_t length, struct rjd_strbuf* out)
+{
+	struct css_names names = critical->template_names;
+	critical_css_collect(critical, html, length, &names);
+	rjd_strbuf_clear(out);
+	css_append_rules(critical, 0, rjd_array_count(critical->rules), &names, out);
+}
+
+// Line and column of at in the markdown
+GEN_INTERNAL struct gen_diagnostic diagnostic_at(const char* message, const char* markdown, const char* at)
+{
+	struct gen_diagnostic diagnostic = { .message = message, .line = 1, .column = 1 };
+	for (const char* next = markdown; next < at; ++next) {
+		if (*next == '\n') {
+			++diagnostic.line;
+			diagnostic.column = 1;
+		} else {
+			++diagnostic.column;
+		}
+	}
+	return diagnostic;
+}
+
+// Renders markdown into scratch->page. The body is rendered first since the header needs the page
+// title, then the template's header and footer are appended after it, so spans are the three parts
+// in page order. A NULL template renders only the body. The title field is filled out from the
+// page's first header, and meta for the site index. A block that doesn't parse is described in
+// diagnostic, and the page is rendered from the blocks before it. label names the page in the trace.
+// Returns false if there was a diagnostic.
+GEN_INTERNAL bool render_markdown_page(const char* markdown, size_t length, const char* label, const struct page_template* template, 
+	struct page_fields* fields, struct page_meta* meta, struct render_state* render, struct transform_scratch* scratch, 
+	struct output_span spans[3], struct gen_diagnostic* diagnostic)
+{
+	struct transform_timings* timings = &scratch->timings;
+	struct rjd_timer timer = rjd_timer_init();
+	struct trace_buffer* trace = scratch->trace;
+	double trace_begin = trace_now(trace);
+
+	// The page buffer lives in the scratch since it's reused as-is from page to page. Everything else
+	// is allocated from the arena, which gets reset when the page is done.
+	const uint32_t token_count = tokenize_count(markdown, length);
+	const size_t arena_required = ((size_t)token_count + 1) * sizeof(struct token) + 4096;
+	struct rjd_mem_allocator* alloc = page_arena_begin(&scratch->arena, arena_required);
+
+	struct token* tokens = tokenize(markdown, length, token_count, alloc);
+
+	timings->tokenize += rjd_timer_elapsed(&timer);
+	rjd_timer_restart(&timer);
+	trace_begin = trace_scope(trace, "tokenize", label, trace_begin);
+	trace_count(trace, TRACE_COUNTER_TOKENS, rjd_array_count(tokens));
+
+	const uint32_t doc_capacity = document_capacity(rjd_array_count(tokens));
+	struct rjd_mem_allocator* doc_alloc = page_arena_begin(&scratch->doc_arena, document_memory_required(doc_capacity));
+	struct document doc = document_init(doc_capacity, doc_alloc);
+	uint32_t consumed = 0;
+	struct rjd_result parse_result = parse_document(&doc, tokens, true, &consumed);
+	if (!rjd_result_isok(parse_result)) {
+		// consumed ends where the block that failed starts
+		const char* at = consumed < rjd_array_count(tokens) ? tokens[consumed].text : markdown + length;
+		*diagnostic = diagnostic_at(parse_result.error, markdown, at);
+	}
+
+	timings->parse += rjd_timer_elapsed(&timer);
+	rjd_timer_restart(&timer);
+	trace_begin = trace_scope(trace, "parse", label, trace_begin);
+
+	struct rjd_strbuf* page = &scratch->page;
+	rjd_strbuf_clear(page);
+
+	render->html = &scratch->html;
+	const uint32_t block_count = render_document(&doc, render, page);
+
+	timings->render += rjd_timer_elapsed(&timer);
+	rjd_timer_restart(&timer);
+	trace_begin = trace_scope(trace, "render", label, trace_begin);
+	trace_count(trace, TRACE_COUNTER_BLOCKS, block_count);
+
+	if (doc.title) {
+		page_fields_set(fields, PAGE_FIELD_TITLE, doc.title->text, doc.title->length);
+	}
+	page_meta_init(meta, &doc, fields);
+	page_arena_end(&scratch->arena);
+	page_arena_end(&scratch->doc_arena);
+
+	const uint32_t body_end = page->length;
+	if (template && template->critical_css) {
+		critical_css_select(template->critical_css, rjd_strbuf_str(page), body_end, &scratch->style);
+		fields->style = rjd_strbuf_str(&scratch->style);
+		fields->style_length = scratch->style.length;
+		timings->critical_css_bytes += scratch->style.length;
+	}
+	if (template) {
+		page_template_render(template, 0, template->body_op, fields, page);
+	}
+	const uint32_t header_end = page->length;
+	if (template) {
+		page_template_render(template, template->body_op + 1, rjd_array_count(template->ops), fields, page);
+	}
+
+	timings->emit += rjd_timer_elapsed(&timer);
+	trace_scope(trace, "emit", label, trace_begin);
+
+	const char* page_str = rjd_strbuf_str(page);
+	spans[0] = (struct output_span){ page_str + body_end, header_end - body_end };
+	spans[1] = (struct output_span){ page_str, body_end };
+	spans[2] = (struct output_span){ page_str + header_end, page->length - header_end };
+
+	timings->pages += 1;
+	timings->bytes_in += length;
+	timings->bytes_out += page->length;
+	if (render->minify) {
+		timings->minified_bytes += render->minified_bytes + (template ? template->minified_bytes : 0);
+	}
+	return rjd_result_isok(parse_result);
+}
+
+// The page is rendered by render_markdown_page(), and sidecars are written as in
+// write_compressed_sidecars(). render has the minify and asset settings, which the template must
+// have been parsed with as well.
+GEN_INTERNAL struct rjd_result transform_markdown_file(const char* path_md, const char* path_html, const struct page_template* template, struct page_fields* fields, 
+	struct page_meta* meta, struct render_state render, const struct compress_settings* compress, uint8_t* sidecars, struct transform_scratch* scratch, struct rjd_strbuf* log)
+{
+	struct transform_timings* timings = &scratch->timings;
+	struct rjd_timer timer = rjd_timer_init();
+	struct trace_buffer* trace = scratch->trace;
+	double trace_begin = trace_now(trace);
+
+	// tokens point straight into the source, so it stays open until the page is written
+	struct source_file source;
+	RJD_RESULT_PROMOTE(source_file_open(&source, path_md, scratch));
+
+	timings->read += rjd_timer_elapsed(&timer);
+	trace_scope(trace, "read", path_md, trace_begin);
+	trace_count(trace, TRACE_COUNTER_BYTES_READ, source.size);
+
+	struct output_span spans[3];
+	struct gen_diagnostic diagnostic;
+	if (!render_markdown_page(source.contents, source.size, path_md, template, fields, meta, &render, scratch, spans, &diagnostic)) {
+		rjd_strbuf_append(log, "Error (%s:%u:%u): %s\n", path_md, diagnostic.line, diagnostic.column, diagnostic.message);
+	}
+
+	const uint32_t page_length = spans[0].length + spans[1].length + spans[2].length;
+	if (template->critical_css) {
+		rjd_strbuf_append(log, "\tinlined %u bytes of css\n", scratch->style.length);
+	}
+	if (render.minify) {
+		log_minified(log, render.minified_bytes + template->minified_bytes, page_length);
+	}
+
+	rjd_timer_restart(&timer);
+	trace_begin = trace_now(trace);
+
+	// ensure the path exists
+	{
+		struct rjd_path output_folder = rjd_path_init_with(path_html);
+		rjd_path_pop(&output_folder);
+		rjd_fio_mkdir(rjd_path_get(&output_folder));
+	}
+
+	struct rjd_result result = write_output_file(path_html, spans, rjd_countof(spans), timings);
+	source_file_close(&source);
+
+	timings->write += rjd_timer_elapsed(&timer);
+	trace_scope(trace, "write", path_html, trace_begin);
+	trace_count(trace, TRACE_COUNTER_BYTES_WRITTEN, page_length);
+
+	// the page buffer is still intact, so the sidecars are compressed straight from it
+	if (rjd_result_isok(result)) {
+		result = write_compressed_sidecars(path_html, spans, rjd_countof(spans), compress, sidecars, scratch);
+	}
+
+	return result;
+}
+
+// --stream reads markdown from one file and writes the page to another, a block at a time, so
+// memory stays proportional to the largest block rather than the whole document. The page title is
+// the first header in the first blocks parsed, since the template header has to go out before them.
+#define GEN_STREAM_CHUNK_SIZE (64 * 1024)
+
+// in_name is only used to label errors in the log
+GEN_INTERNAL struct rjd_result transform_markdown_stream(FILE* in, const char* in_name, FILE* out, const struct page_template* template, 
+	bool minify, struct transform_scratch* scratch, struct rjd_strbuf* log)
+{
+	struct page_fields fields;
+	page_fields_init(&fields, "", "");
+
+	// copied out of the markdown since the footer may use it after the source text is gone
+	struct rjd_strbuf title = rjd_strbuf_init(scratch->alloc);
+
+	// markdown read from in that hasn't been parsed into a complete block yet
+	char* pending = scratch->read_buffer;
+	rjd_array_clear(pending);
+
+	struct rjd_strbuf* page = &scratch->page;
+	struct render_state render = { .minify = minify };
+	struct rjd_result result = RJD_RESULT_OK();
+	size_t read_size = GEN_STREAM_CHUNK_SIZE;
+	bool wrote_header = false;
+	bool parse_failed = false;
+	bool finished = false;
+
+	while (!finished)
+	{
+		const uint32_t kept = rjd_array_count(pending);
+		rjd_array_resize(pending, (uint32_t)(kept + read_size));
+		const size_t read = fread(pending + kept, 1, read_size, in);
+		rjd_array_resize(pending, (uint32_t)(kept + read));
+		if (ferror(in)) {
+			result = RJD_RESULT("Failed to read markdown");
+			break;
+		}
+		finished = read < read_size;
+
+		// after a parse error the rest of the markdown is dropped, same as for a file
+		if (parse_failed) {
+			rjd_array_clear(pending);
+			continue;
+		}
+
+		const uint32_t pending_count = rjd_array_count(pending);
+		const uint32_t token_count = tokenize_count(pending, pending_count);
+		const size_t arena_required = ((size_t)token_count + 1) * sizeof(struct token) + 4096;
+		struct rjd_mem_allocator* alloc = page_arena_begin(&scratch->arena, arena_required);
+		struct token* tokens = tokenize(pending, pending_count, token_count, alloc);
+
+		const uint32_t doc_capacity = document_capacity(rjd_array_count(tokens));
+		struct rjd_mem_allocator* doc_alloc = page_arena_begin(&scratch->doc_arena, document_memory_required(doc_capacity));
+		struct document doc = document_init(doc_capacity, doc_alloc);
+		uint32_t consumed = 0;
+		struct rjd_result parse_result = parse_document(&doc, tokens, finished, &consumed);
+		if (!rjd_result_isok(parse_result)) {
+			rjd_strbuf_append(log, "Error (%s): %s\n", in_name, parse_result.error);
+			parse_failed = true;
+		}
+
+		rjd_strbuf_clear(page);
+		if (!wrote_header && (document_count(&doc) > 0 || finished || parse_failed)) {
+			if (doc.title) {
+				rjd_strbuf_appendl(&title, doc.title->text, doc.title->length);
+				page_fields_set(&fields, PAGE_FIELD_TITLE, rjd_strbuf_str(&title), title.length);
+			}
+			page_template_render(template, 0, template->body_op, &fields, page);
+			wrote_header = true;
+		}
+		render_document(&doc, &render, page);
+
+		if (page->length > 0 && fwrite(rjd_strbuf_str(page), 1, page->length, out) != page->length) {
+			result = RJD_RESULT("Failed to write html");
+			break;
+		}
+
+		// keep the text of the unfinished block for the next pass
+		const uint32_t consumed_bytes = consumed < rjd_array_count(tokens) ? 
+			(uint32_t)(tokens[consumed].text - pending) : pending_count;
+		memmove(pending, pending + consumed_bytes, pending_count - consumed_bytes);
+		rjd_array_resize(pending, pending_count - consumed_bytes);
+
+		page_arena_end(&scratch->arena);
+		page_arena_end(&scratch->doc_arena);
+
+		// A block bigger than a chunk is tokenized again on every pass, so read as much again as is
+		// pending to keep the total work linear in the block's size
+		read_size = rjd_math_max_sizet(GEN_STREAM_CHUNK_SIZE, rjd_array_count(pending));
+	}
+
+	scratch->read_buffer = pending;
+
+	rjd_strbuf_clear(page);
+	if (!wrote_header) {
+		page_template_render(template, 0, template->body_op, &fields, page);
+	}
+	page_template_render(template, template->body_op + 1, rjd_array_count(template->ops), &fields, page);
+	if (fwrite(rjd_strbuf_str(page), 1, page->length, out) != page->length && rjd_result_isok(result)) {
+		result = RJD_RESULT("Failed to write html");
+	}
+	fflush(out);
+
+	rjd_strbuf_free(&title);
+	return result;
+}
+
+// The library side of gen.h. A renderer has what a build worker has for rendering a page, minus the
+// files: the template, the scratch, and a cache of rendered pages.
+#define RENDER_CACHE_NONE UINT32_MAX
+
+struct render_cache_entry
+{
+	uint64_t key;
+	size_t markdown_length; // checked along with the key so a hash collision is a miss
+	char* html; // NULL while the slot is free
+	size_t html_length;
+	struct page_meta meta;
+	struct gen_diagnostic diagnostic;
+	uint32_t diagnostic_count;
+	uint32_t newer; // the recently used list, RENDER_CACHE_NONE past either end
+	uint32_t older;
+};
+
+// Pages are keyed by a hash of their markdown and path. Once either limit is reached, the least
+// recently used pages are evicted to make room.
+struct render_cache
+{
+	struct render_cache_entry* entries; // capacity slots
+	uint32_t* free_slots; // rjd_array
+	struct rjd_dict lookup; // key to slot + 1
+	uint32_t capacity;
+	size_t max_bytes; // 0 for no limit
+	uint32_t newest;
+	uint32_t oldest;
+	struct gen_cache_stats stats;
+};
+
+GEN_INTERNAL struct render_cache render_cache_init(uint32_t capacity, size_t max_bytes, struct rjd_mem_allocator* alloc)
+{
+	struct render_cache cache = {
+		.capacity = capacity,
+		.max_bytes = max_bytes,
+		.newest = RENDER_CACHE_NONE,
+		.oldest = RENDER_CACHE_NONE,
+	};
+	if (capacity == 0) {
+		return cache;
+	}
+
+	cache.entries = rjd_mem_alloc_array(struct render_cache_entry, capacity, alloc);
+	cache.free_slots = rjd_array_alloc(uint32_t, capacity, alloc);
+	cache.lookup = rjd_dict_init(alloc, capacity);
+	// popped from the back, so slots fill in order
+	for (uint32_t i = capacity; i > 0; --i) {
+		rjd_array_push(cache.free_slots, i - 1);
+	}
+	return cache;
+}
+
+GEN_INTERNAL void render_cache_free(struct render_cache* cache)
+{
+	if (cache->capacity == 0) {
+		return;
+	}
+	for (uint32_t i = 0; i < cache->capacity; ++i) {
+		if (cache->entries[i].html) {
+			rjd_mem_free(cache->entries[i].html);
+		}
+	}
+	rjd_mem_free(cache->entries);
+	rjd_array_free(cache->free_slots);
+	rjd_dict_free(&cache->lookup);
+}
+
+GEN_INTERNAL void render_cache_unlink(struct render_cache* cache, uint32_t slot)
+{
+	struct render_cache_entry* entry = cache->entries + slot;
+	if (entry->newer == RENDER_CACHE_NONE) {
+		cache->newest = entry->older;
+	} else {
+		cache->entries[entry->newer].older = entry->older;
+	}
+	if (entry->older == RENDER_CACHE_NONE) {
+		cache->oldest = entry->newer;
+	} else {
+		cache->entries[entry->older].newer = entry->newer;
+	}
+}
+
+GEN_INTERNAL void render_cache_link_newest(struct render_cache* cache, uint32_t slot)
+{
+	struct render_cache_entry* entry = cache->entries + slot;
+	entry->newer = RENDER_CACHE_NONE;
+	entry->older = cache->newest;
+	if (cache->newest == RENDER_CACHE_NONE) {
+		cache->oldest = slot;
+	} else {
+		cache->entries[cache->newest].newer = slot;
+	}
+	cache->newest = slot;
+}
+
+GEN_INTERNAL void render_cache_evict(struct render_cache* cache, uint32_t slot)
+{
+	struct render_cache_entry* entry = cache->entries + slot;
+	render_cache_unlink(cache, slot);
+	rjd_dict_erase(&cache->lookup, (struct rjd_hash64){ entry->key });
+
+	cache->stats.entries -= 1;
+	cache->stats.bytes -= entry->html_length;
+	cache->stats.evictions += 1;
+
+	rjd_mem_free(entry->html);
+	entry->html = NULL;
+	rjd_array_push(cache->free_slots, slot);
+}
+
+GEN_INTERNAL uint64_t render_cache_key(const char* markdown, size_t length, const char* path)
+{
+	const uint64_t key[] = { rjd_hash64_data((const uint8_t*)markdown, length).value, rjd_hash64_str(path).value };
+	return rjd_hash64_data((const uint8_t*)key, sizeof(key)).value;
+}
+
+// Counts a hit or miss. Returns NULL on a miss, otherwise the entry, which becomes the newest.
+GEN_INTERNAL const struct render_cache_entry* render_cache_find(struct render_cache* cache, uint64_t key, size_t markdown_length)
+{
+	if (cache->capacity == 0) {
+		return NULL;
+	}
+
+	const uintptr_t index = (uintptr_t)rjd_dict_get(&cache->lookup, (struct rjd_hash64){ key });
+	if (index == 0 || cache->entries[index - 1].markdown_length != markdown_length) {
+		cache->stats.misses += 1;
+		return NULL;
+	}
+
+	cache->stats.hits += 1;
+	render_cache_unlink(cache, (uint32_t)index - 1);
+	render_cache_link_newest(cache, (uint32_t)index - 1);
+	return cache->entries + index - 1;
+}
+
+// Copies the page into the cache unless it's bigger than the cache's byte limit. An entry with the
+// same key is replaced, which only happens when render_cache_find() caught a hash collision.
+GEN_INTERNAL void render_cache_insert(struct render_cache* cache, uint64_t key, size_t markdown_length, const struct rjd_strbuf* html, 
+	const struct page_meta* meta, const struct gen_diagnostic* diagnostics, uint32_t diagnostic_count, struct rjd_mem_allocator* alloc)
+{
+	if (cache->capacity == 0 || (cache->max_bytes > 0 && html->length > cache->max_bytes)) {
+		return;
+	}
+
+	const uintptr_t existing = (uintptr_t)rjd_dict_get(&cache->lookup, (struct rjd_hash64){ key });
+	if (existing != 0) {
+		render_cache_evict(cache, (uint32_t)existing - 1);
+	}
+	while (rjd_array_count(cache->free_slots) == 0 || (cache->max_bytes > 0 && cache->stats.bytes + html->length > cache->max_bytes)) {
+		render_cache_evict(cache, cache->oldest);
+	}
+
+	const uint32_t slot = rjd_array_pop(cache->free_slots);
+
+	struct render_cache_entry* entry = cache->entries + slot;
+	entry->key = key;
+	entry->markdown_length = markdown_length;
+	entry->html = rjd_mem_alloc_array_noclear(char, html->length + 1, alloc);
+	memcpy(entry->html, rjd_strbuf_str(html), html->length + 1);
+	entry->html_length = html->length;
+	entry->meta = *meta;
+	entry->diagnostic_count = diagnostic_count;
+	if (diagnostic_count > 0) {
+		entry->diagnostic = diagnostics[0];
+	}
+	render_cache_link_newest(cache, slot);
+	rjd_dict_insert(&cache->lookup, (struct rjd_hash64){ key }, (void*)(uintptr_t)(slot + 1));
+
+	cache->stats.entries += 1;
+	cache->stats.bytes += html->length;
+}
+
+struct gen_renderer
+{
+	struct rjd_mem_allocator alloc;
+	struct page_template template;
+	bool body_only;
+	bool minify;
+	struct transform_scratch scratch;
+	struct render_cache cache;
+
+	// the last page rendered, for gen_page to point into
+	struct rjd_strbuf html;
+	struct page_meta meta;
+	struct gen_diagnostic diagnostic;
+};
+
+#if defined(_WIN32)
+GEN_INTERNAL BOOL CALLBACK text_scan_init_detect(PINIT_ONCE once, PVOID parameter, PVOID* context)
+{
+	(void)once;
+	(void)parameter;
+	(void)context;
+	text_scan_init(TEXT_SCAN_ISA_DETECT);
+	return TRUE;
+}
+#else
+GEN_INTERNAL void text_scan_init_detect(void)
+{
+	text_scan_init(TEXT_SCAN_ISA_DETECT);
+}
+#endif
+
+// text_scan_init() sets the globals tokenize() reads, so it runs once no matter how many threads
+// create renderers. The others block until it's done.
+GEN_INTERNAL void text_scan_init_once(void)
+{
+#if defined(_WIN32)
+	static INIT_ONCE once = INIT_ONCE_STATIC_INIT;
+	InitOnceExecuteOnce(&once, text_scan_init_detect, NULL, NULL);
+#else
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, text_scan_init_detect);
+#endif
+}
+
+struct gen_renderer* gen_renderer_create(const struct gen_renderer_desc* desc, struct gen_diagnostic* error)
+{
+	text_scan_init_once();
+
+	// malloc'd since everything else is allocated from the allocator inside it
+	struct gen_renderer* renderer = malloc(sizeof(*renderer));
+	if (renderer == NULL) {
+		if (error) {
+			*error = (struct gen_diagnostic){ .message = "Out of memory" };
+		}
+		return NULL;
+	}
+	memset(renderer, 0, sizeof(*renderer));
+	renderer->alloc = rjd_mem_allocator_init_default();
+	renderer->body_only = desc->body_only;
+	renderer->minify = desc->minify;
+
+	if (!desc->body_only) {
+		const char* text = desc->template_text ? desc->template_text : DEFAULT_PAGE_TEMPLATE;
+		const size_t length = desc->template_text ? desc->template_length : strlen(DEFAULT_PAGE_TEMPLATE);
+		struct rjd_result result = page_template_parse(&renderer->template, text, length, desc->minify, false, NULL, &renderer->alloc);
+		if (!rjd_result_isok(result)) {
+			if (error) {
+				*error = (struct gen_diagnostic){ .message = result.error };
+			}
+			free(renderer);
+			return NULL;
+		}
+	}
+
+	renderer->scratch = transform_scratch_init(&renderer->alloc);
+	renderer->cache = render_cache_init(desc->cache_entries, desc->cache_bytes, &renderer->alloc);
+	renderer->html = rjd_strbuf_init(&renderer->alloc);
+	return renderer;
+}
+
+void gen_renderer_destroy(struct gen_renderer* renderer)
+{
+	if (renderer == NULL) {
+		return;
+	}
+	if (!renderer->body_only) {
+		page_template_free(&renderer->template);
+	}
+	transform_scratch_free(&renderer->scratch);
+	render_cache_free(&renderer->cache);
+	rjd_strbuf_free(&renderer->html);
+	free(renderer);
+}
+
+bool gen_render(struct gen_renderer* renderer, const char* markdown, size_t length, const char* path, struct gen_page* out)
+{
+	path = path ? path : "";
+	const uint64_t key = render_cache_key(markdown, length, path);
+	const struct render_cache_entry* entry = render_cache_find(&renderer->cache, key, length);
+	if (entry) {
+		*out = (struct gen_page){
+			.html = entry->html,
+			.html_length = entry->html_length,
+			.title = entry->meta.title,
+			.summary = entry->meta.summary,
+			.diagnostics = &entry->diagnostic,
+			.diagnostic_count = entry->diagnostic_count,
+			.cached = true,
+		};
+		return entry->diagnostic_count == 0;
+	}
+
+	const struct rjd_path root = page_root_path(path);
+	struct page_fields fields;
+	page_fields_init(&fields, path, rjd_path_get(&root));
+
+	struct render_state render = { .minify = renderer->minify };
+	const struct page_template* template = renderer->body_only ? NULL : &renderer->template;
+	struct output_span spans[3];
+	const bool ok = render_markdown_page(markdown, length, path, template, &fields, &renderer->meta, &render, &renderer->scratch, spans, &renderer->diagnostic);
+
+	rjd_strbuf_clear(&renderer->html);
+	for (uint32_t i = 0; i < rjd_countof(spans); ++i) {
+		rjd_strbuf_appendl(&renderer->html, spans[i].data, spans[i].length);
+	}
+
+	const uint32_t diagnostic_count = ok ? 0 : 1;
+	render_cache_insert(&renderer->cache, key, length, &renderer->html, &renderer->meta, &renderer->diagnostic, diagnostic_count, &renderer->alloc);
+
+	*out = (struct gen_page){
+		.html = rjd_strbuf_str(&renderer->html),
+		.html_length = renderer->html.length,
+		.title = renderer->meta.title,
+		.summary = renderer->meta.summary,
+		.diagnostics = &renderer->diagnostic,
+		.diagnostic_count = diagnostic_count,
+	};
+	return ok;
+}
+
+struct gen_cache_stats gen_renderer_cache_stats(const struct gen_renderer* renderer)
+{
+	return renderer->cache.stats;
+}
+
+// Bump when a generator change alters output. The build timestamp is folded in as well, so a
+// fresh build of gen always invalidates the manifest.
+#define GEN_VERSION "6"
+#define GEN_MANIFEST_FILENAME ".gen-manifest"
+
+struct file_stamp
+{
+	uint64_t size;
+	int64_t mtime_ns;
+};
+
+struct manifest_entry
+{
+	struct rjd_path path_output; // relative to the output folder
+	struct file_stamp input_stamp;
+	uint64_t input_hash;
+	uint64_t template_hash; // also covers the compression settings
+	uint8_t sidecars; // bit per compress_format written next to the output
+	uint64_t fingerprint; // 0 unless the output was also written under a fingerprinted name
+	uint32_t image_width; // images only, so their headers aren't read again. 0 if it couldn't be read.
+	uint32_t image_height;
+	struct page_meta meta; // markdown pages only
+};
+
+// Records what each output was built from, so outputs whose input file and page template haven't
+// changed since the last run can be skipped.
+struct manifest
+{
+	uint64_t generator_hash;
+	struct manifest_entry* entries;
+	struct rjd_dict lookup; // hash of path_output -> index+1 into entries
+};
+
+GEN_INTERNAL uint64_t generator_hash(void)
+{
+	const char* identity = GEN_VERSION " " __DATE__ " " __TIME__;
+	return rjd_hash64_str(identity).value;
+}
+
+GEN_INTERNAL bool file_stamp_get(const char* path, struct file_stamp* out)
+{
+	struct stat info;
+	if (stat(path, &info) != 0) {
+		return false;
+	}
+
+	out->size = (uint64_t)info.st_size;
+#if defined(__APPLE__)
+	out->mtime_ns = (int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+	out->mtime_ns = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#else
+	out->mtime_ns = (int64_t)info.st_mtime * 1000000000;
+#endif
+	return true;
+}
+
+GEN_INTERNAL bool file_stamp_equals(struct file_stamp a, struct file_stamp b)
+{
+	return a.size == b.size && a.mtime_ns == b.mtime_ns;
+}
+
+GEN_INTERNAL struct rjd_result file_hash(const char* path, uint64_t* out, struct transform_scratch* scratch)
+{
+	struct source_file file;
+	RJD_RESULT_PROMOTE(source_file_open(&file, path, scratch));
+	*out = rjd_hash64_data((const uint8_t*)file.contents, file.size).value;
+	source_file_close(&file);
+	return RJD_RESULT_OK();
+}
+
+// The template and assets are everything about a page's output that doesn't come from its markdown
+// file. The other page fields all come from the page's path, which is already the manifest key.
+GEN_INTERNAL uint64_t page_template_hash(const struct page_template* template, const struct asset_map* assets, const char* path_root)
+{
+	const uint64_t key[] = { template->hash, assets ? assets->hash : 0, rjd_hash64_str(path_root).value };
+	return rjd_hash64_data((const uint8_t*)key, sizeof(key)).value;
+}
+
+GEN_INTERNAL struct manifest manifest_init(struct rjd_mem_allocator* alloc)
+{
+	struct manifest manifest = {
+		.generator_hash = generator_hash(),
+		.entries = rjd_array_alloc(struct manifest_entry, 256, alloc),
+		.lookup = rjd_dict_init(alloc, 256),
+	};
+	return manifest;
+}
+
+GEN_INTERNAL void manifest_free(struct manifest* manifest)
+{
+	rjd_array_free(manifest->entries);
+	rjd_dict_free(&manifest->lookup);
+}
+
+// Replaces any existing entry for the same output
+GEN_INTERNAL void manifest_add(struct manifest* manifest, const struct manifest_entry* entry)
+{
+	const struct rjd_hash64 hash = rjd_hash64_str(rjd_path_get(&entry->path_output));
+	uintptr_t index = (uintptr_t)rjd_dict_get(&manifest->lookup, hash);
+	if (index != 0) {
+		manifest->entries[index - 1] = *entry;
+		return;
+	}
+
+	rjd_array_push(manifest->entries, *entry);
+	index = rjd_array_count(manifest->entries);
+	rjd_dict_insert(&manifest->lookup, hash, (void*)index);
+}
+
+GEN_INTERNAL void manifest_remove(struct manifest* manifest, const char* path_output)
+{
+	const struct rjd_hash64 hash = rjd_hash64_str(path_output);
+	uintptr_t index = (uintptr_t)rjd_dict_erase(&manifest->lookup, hash);
+	if (index == 0) {
+		return;
+	}
+
+	// Swap the last entry into the hole and point its lookup at the new slot
+	const uint32_t last = rjd_array_count(manifest->entries) - 1;
+	if (index - 1 != last) {
+		rjd_dict_insert(&manifest->lookup, rjd_hash64_str(rjd_path_get(&manifest->entries[last].path_output)), (void*)index);
+	}
+	rjd_array_erase_unordered(manifest->entries, index - 1);
+}
+
+GEN_INTERNAL const struct manifest_entry* manifest_find(const struct manifest* manifest, const char* path_output)
+{
+	uintptr_t index = (uintptr_t)rjd_dict_get(&manifest->lookup, rjd_hash64_str(path_output));
+	if (index == 0) {
+		return NULL;
+	}
+	const struct manifest_entry* entry = manifest->entries + index - 1;
+	if (strcmp(rjd_path_get(&entry->path_output), path_output)) {
+		return NULL;
+	}
+	return entry;
+}
+
+// Format is a header line with the generator hash, then one line per output, tab separated after the path:
+//	<input hash> <template hash> <input size> <input mtime> <sidecars> <fingerprint> <image width> <image height> <output path>	<date>	<title>	<summary>
+// A manifest from a different generator is treated as empty so everything rebuilds.
+GEN_INTERNAL struct rjd_result manifest_read(struct manifest* manifest, const char* path, struct rjd_mem_allocator* alloc)
+{
+	char* contents = NULL;
+	RJD_RESULT_PROMOTE(rjd_fio_read(path, &contents, alloc));
+
+	const char* next = contents;
+	const char* end = contents + rjd_array_count(contents);
+
+	uint64_t file_generator_hash = 0;
+	if (sscanf(next, "gen-manifest %" SCNx64, &file_generator_hash) != 1 || file_generator_hash != manifest->generator_hash) {
+		rjd_array_free(contents);
+		return RJD_RESULT("manifest is from a different generator");
+	}
+
+	while (next < end && *next != '\n') {
+		++next;
+	}
+
+	while (next < end)
+	{
+		++next;
+		const char* line_end = next;
+		while (line_end < end && *line_end != '\n') {
+			++line_end;
+		}
+
+		struct manifest_entry entry = {0};
+		int path_offset = 0;
+		unsigned sidecars = 0;
+		int parsed = sscanf(next, "%" SCNx64 " %" SCNx64 " %" SCNu64 " %" SCNd64 " %u %" SCNx64 " %" SCNu32 " %" SCNu32 " %n",
+			&entry.input_hash, &entry.template_hash, &entry.input_stamp.size, &entry.input_stamp.mtime_ns, &sidecars, &entry.fingerprint, 
+			&entry.image_width, &entry.image_height, &path_offset);
+		entry.sidecars = (uint8_t)(sidecars & COMPRESS_FORMAT_ALL_BITS);
+
+		if (parsed == 8 && path_offset > 0 && next + path_offset < line_end) {
+			// the path, then each page_meta string
+			char* fields[] = { NULL, entry.meta.date, entry.meta.title, entry.meta.summary };
+			const size_t capacities[] = { RJD_PATH_BUFFER_LENGTH, sizeof(entry.meta.date), sizeof(entry.meta.title), sizeof(entry.meta.summary) };
+			char path_output[RJD_PATH_BUFFER_LENGTH] = {0};
+			fields[0] = path_output;
+
+			const char* field_begin = next + path_offset;
+			for (uint32_t i = 0; i < rjd_countof(fields) && field_begin <= line_end; ++i) {
+				const char* field_end = field_begin;
+				while (field_end < line_end && *field_end != '\t') {
+					++field_end;
+				}
+				size_t length = rjd_math_min_sizet((size_t)(field_end - field_begin), capacities[i] - 1);
+				memcpy(fields[i], field_begin, length);
+				field_begin = field_end + 1;
+			}
+
+			entry.path_output = rjd_path_init_with(path_output);
+			manifest_add(manifest, &entry);
+		}
+
+		next = line_end;
+	}
+
+	rjd_array_free(contents);
+	return RJD_RESULT_OK();
+}
+
+GEN_INTERNAL struct rjd_result manifest_write(const struct manifest* manifest, const char* path, struct rjd_mem_allocator* alloc)
+{
+	struct rjd_strbuf out = rjd_strbuf_init(alloc);
+	rjd_strbuf_append(&out, "gen-manifest %016" PRIx64 "\n", manifest->generator_hash);
+
+	for (uint32_t i = 0; i < rjd_array_count(manifest->entries); ++i) {
+		const struct manifest_entry* entry = manifest->entries + i;
+		rjd_strbuf_append(&out, "%016" PRIx64 " %016" PRIx64 " %" PRIu64 " %" PRId64 " %u %" PRIx64 " %" PRIu32 " %" PRIu32 " %s\t%s\t%s\t%s\n",
+			entry->input_hash, entry->template_hash, entry->input_stamp.size, entry->input_stamp.mtime_ns, (unsigned)entry->sidecars, 
+			entry->fingerprint, entry->image_width, entry->image_height, rjd_path_get(&entry->path_output),
+			entry->meta.date, entry->meta.title, entry->meta.summary);
+	}
+
+	struct rjd_result result = rjd_fio_write(path, rjd_strbuf_str(&out), out.length, RJD_FIO_WRITEMODE_REPLACE);
+	rjd_strbuf_free(&out);
+	return result;
+}
+
+enum copy_method
+{
+	COPY_METHOD_HARDLINK,
+	COPY_METHOD_REFLINK,
+	COPY_METHOD_COPY_FILE_RANGE,
+	COPY_METHOD_SENDFILE,
+	COPY_METHOD_CLONEFILE,
+	COPY_METHOD_READ_WRITE,
+	COPY_METHOD_COUNT,
+};
+
+GEN_INTERNAL const char* COPY_METHOD_NAMES[] =
+{
+	"hardlink",
+	"reflink",
+	"copy_file_range",
+	"sendfile",
+	"clonefile",
+	"read/write",
+};
+RJD_STATIC_ASSERT(rjd_countof(COPY_METHOD_NAMES) == COPY_METHOD_COUNT);
+
+// Copies are done with the fastest method the platform and filesystem allow. Copies preserve
+// the source's mtime so the destination can be checked cheaply on the next run. Hardlinks are
+// opt-in since editing the output would then edit the source too.
+GEN_INTERNAL struct rjd_result copy_file(const char* path_src, const char* path_dst, bool allow_hardlink, enum copy_method* out_method)
+{
+#if defined(__linux__)
+	// The destination may be a hardlink to the source from an earlier --link-assets build, so it has to
+	// be unlinked rather than truncated
+	unlink(path_dst);
+
+	if (allow_hardlink) {
+		if (link(path_src, path_dst) == 0) {
+			*out_method = COPY_METHOD_HARDLINK;
+			return RJD_RESULT_OK();
+		}
+	}
+
+	int fd_src = open(path_src, O_RDONLY | O_CLOEXEC);
+	if (fd_src < 0) {
+		return RJD_RESULT("Failed to open copy source for read");
+	}
+
+	struct stat info;
+	if (fstat(fd_src, &info) != 0) {
+		close(fd_src);
+		return RJD_RESULT("Failed to stat copy source");
+	}
+
+	int fd_dst = open(path_dst, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777);
+	if (fd_dst < 0) {
+		close(fd_src);
+		return RJD_RESULT("Failed to open copy destination for write");
+	}
+
+	struct rjd_result result = RJD_RESULT_OK();
+
+	if (ioctl(fd_dst, FICLONE, fd_src) == 0) {
+		*out_method = COPY_METHOD_REFLINK;
+	} else {
+		// Each fallback picks up where the last one left off, since all of them advance the file offsets
+		off_t remaining = info.st_size;
+
+		*out_method = COPY_METHOD_COPY_FILE_RANGE;
+		while (remaining > 0) {
+			ssize_t copied = copy_file_range(fd_src, NULL, fd_dst, NULL, (size_t)remaining, 0);
+			if (copied <= 0) {
+				break;
+			}
+			remaining -= copied;
+		}
+
+		if (remaining > 0) {
+			*out_method = COPY_METHOD_SENDFILE;
+			while (remaining > 0) {
+				ssize_t copied = sendfile(fd_dst, fd_src, NULL, (size_t)remaining);
+				if (copied <= 0) {
+					break;
+				}
+				remaining -= copied;
+			}
+		}
+
+		if (remaining > 0) {
+			*out_method = COPY_METHOD_READ_WRITE;
+			char buffer[64 * 1024];
+			while (remaining > 0) {
+				ssize_t count = read(fd_src, buffer, sizeof(buffer));
+				if (count <= 0 || write(fd_dst, buffer, (size_t)count) != count) {
+					break;
+				}
+				remaining -= count;
+			}
+		}
+
+		if (remaining > 0) {
+			result = RJD_RESULT("Failed to copy file contents");
+		}
+	}
+
+	struct timespec times[2] = { info.st_atim, info.st_mtim };
+	futimens(fd_dst, times);
+
+	close(fd_dst);
+	close(fd_src);
+	return result;
+
+#elif defined(__APPLE__)
+	unlink(path_dst);
+	if (allow_hardlink && link(path_src, path_dst) == 0) {
+		*out_method = COPY_METHOD_HARDLINK;
+		return RJD_RESULT_OK();
+	}
+
+	// COPYFILE_CLONE falls back to a regular data copy if the volume can't clone, and carries over the mtime
+	*out_method = COPY_METHOD_CLONEFILE;
+	if (copyfile(path_src, path_dst, NULL, COPYFILE_CLONE) != 0) {
+		return RJD_RESULT("Failed to copy file");
+	}
+	return RJD_RESULT_OK();
+
+#else
+	RJD_UNUSED_PARAM(allow_hardlink);
+
+	FILE* file_src = fopen(path_src, "rb");
+	if (!file_src) {
+		return RJD_RESULT("Failed to open copy source for read");
+	}
+
+	FILE* file_dst = fopen(path_dst, "wb");
+	if (!file_dst) {
+		fclose(file_src);
+		return RJD_RESULT("Failed to open copy destination for write");
+	}
+
+	*out_method = COPY_METHOD_READ_WRITE;
+
+	struct rjd_result result = RJD_RESULT_OK();
+	char buffer[64 * 1024];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file_src)) > 0) {
+		if (fwrite(buffer, 1, count, file_dst) != count) {
+			result = RJD_RESULT("Failed to copy file contents");
+			break;
+		}
+	}
+
+	fclose(file_dst);
+	fclose(file_src);
+	return result;
+#endif
+}
+
+// Even without a manifest entry, a copy can be skipped if the destination already has the same
+// contents. Matching size and mtime is trusted since copy_file() preserves mtimes.
+GEN_INTERNAL bool is_copy_destination_current(const char* path_src, const char* path_dst, uint64_t src_hash, struct transform_scratch* scratch)
+{
+	struct file_stamp stamp_src;
+	struct file_stamp stamp_dst;
+	if (!file_stamp_get(path_src, &stamp_src) || !file_stamp_get(path_dst, &stamp_dst)) {
+		return false;
+	}
+
+	if (stamp_src.size != stamp_dst.size) {
+		return false;
+	}
+
+	if (stamp_src.mtime_ns == stamp_dst.mtime_ns) {
+		return true;
+	}
+
+	uint64_t dst_hash = 0;
+	return rjd_result_isok(file_hash(path_dst, &dst_hash, scratch)) && dst_hash == src_hash;
+}
+
+enum build_job_type
+{
+	BUILD_JOB_TYPE_MARKDOWN,
+	BUILD_JOB_TYPE_COPY,
+};
+
+struct build_job
+{
+	enum build_job_type type;
+	struct rjd_path path_input;
+	struct rjd_path path_output;
+	struct rjd_path path_root;
+	struct rjd_path path_relative;
+
+	// Filled out by the worker for the next run's manifest. The build is up to date if the
+	// previous manifest had a matching entry and the output still exists.
+	struct manifest_entry manifest_entry;
+	bool built;
+	bool up_to_date;
+
+	// Each job buffers its own log so output from different workers doesn't interleave
+	struct rjd_strbuf log;
+	bool done;
+};
+
+// Jobs are dealt out to each worker's deque up front. A worker pops from the back of its own
+// deque and steals from the front of the others when it runs dry. Since jobs never spawn more
+// jobs, a worker that finds every deque empty is finished.
+struct job_deque
+{
+	struct rjd_lock lock;
+	uint32_t* job_indices;
+	uint32_t head;
+};
+
+struct build_worker
+{
+	struct build_pool* pool;
+	struct job_deque deque;
+	struct rjd_mem_allocator alloc;
+	struct rjd_thread thread;
+	uint32_t index;
+	size_t arena_high_water;
+	size_t doc_arena_high_water;
+	struct transform_timings timings;
+};
+
+struct build_context
+{
+	const struct page_template* page_template;
+	const struct manifest* previous_manifest;
+	bool force_rebuild;
+	bool hardlink_assets;
+	bool print_arena_stats;
+	bool quiet; // only print the logs of jobs that failed
+	bool minify; // the page template is parsed minified as well
+	bool fingerprint;
+	struct compress_settings compress;
+	const struct asset_map* assets; // the page template is parsed with it as well
+
+	// NULL unless tracing. Workers each start their own trace buffer, and jobs run without workers
+	// record into trace_main.
+	struct trace* trace;
+	struct trace_buffer* trace_main;
+};
+
+struct build_pool
+{
+	const struct build_context* context;
+	struct build_job* jobs;
+	struct build_worker* workers;
+	uint32_t worker_count;
+
+	struct rjd_lock done_lock;
+	struct rjd_condvar done_condvar;
+};
+
+// Works out where an input file ends up in the output folder. Only looks at the path, so it also
+// maps input files that have since been deleted.
+GEN_INTERNAL struct build_job build_job_init(const char* path_input, const char* path_source, const char* path_destination)
+{
+	struct build_job job = {
+		.type = BUILD_JOB_TYPE_COPY,
+		.path_input = rjd_path_init_with(path_input),
+		.path_output = rjd_path_init_with(path_input),
+		.path_root = rjd_path_init(),
+		.done = false,
+	};
+	rjd_path_pop_front_path_str(&job.path_output, path_source);
+
+	const bool is_markdown = rjd_path_str_endswith(path_input, ".md");
+	if (is_markdown) {
+		job.type = BUILD_JOB_TYPE_MARKDOWN;
+
+		rjd_path_pop_extension(&job.path_output);
+		rjd_path_append(&job.path_output, ".html");
+
+		struct rjd_path output_copy = job.path_output;
+		rjd_path_join_front(&output_copy, path_destination);
+		rjd_path_pop(&output_copy);
+		rjd_path_pop(&output_copy);
+		while (output_copy.length != 0) {
+			rjd_path_pop(&output_copy);
+			rjd_path_join_str(&job.path_root, "..");
+		}
+
+		if (job.path_root.length > 0) {
+			rjd_path_append(&job.path_root, "/");
+		}
+	}
+
+	job.path_relative = job.path_output;
+	rjd_path_join_front(&job.path_output, path_destination);
+
+	return job;
+}
+
+// Turning compression, minifying or fingerprinting on, or changing a level, rebuilds everything so
+// every output and sidecar matches
+GEN_INTERNAL uint64_t output_settings_hash(const struct build_context* context, uint64_t template_hash)
+{
+	if (!compress_settings_any(&context->compress) && !context->minify && !context->fingerprint) {
+		return template_hash;
+	}
+
+	uint64_t key[3 + COMPRESS_FORMAT_COUNT] = { template_hash, context->minify, context->fingerprint };
+	for (uint32_t format = 0; format < COMPRESS_FORMAT_COUNT; ++format) {
+		key[3 + format] = (uint64_t)context->compress.levels[format];
+	}
+	return rjd_hash64_data((const uint8_t*)key, sizeof(key)).value;
+}
+
+// Covers the output settings as well as the contents, since minifying or compressing differently
+// changes what's served under the name
+GEN_INTERNAL uint64_t asset_fingerprint(uint64_t input_hash, uint64_t template_hash)
+{
+	const uint64_t key[] = { input_hash, template_hash };
+	return rjd_hash64_data((const uint8_t*)key, sizeof(key)).value;
+}
+
+// Checks the job's inputs against the previous manifest, filling out the job's new manifest entry
+// along the way. Input files are only hashed if their size or mtime has changed.
+GEN_INTERNAL bool is_build_job_up_to_date(struct build_job* job, const struct build_context* context, struct transform_scratch* scratch)
+{
+	const struct manifest* previous_manifest = context->previous_manifest;
+	struct manifest_entry* entry = &job->manifest_entry;
+	entry->path_output = job->path_relative;
+	entry->template_hash = 0;
+	if (job->type == BUILD_JOB_TYPE_MARKDOWN) {
+		entry->template_hash = page_template_hash(context->page_template, context->assets, rjd_path_get(&job->path_root));
+	}
+
+	entry->template_hash = output_settings_hash(context, entry->template_hash);
+
+	if (!file_stamp_get(rjd_path_get(&job->path_input), &entry->input_stamp)) {
+		return false;
+	}
+
+	const struct manifest_entry* previous = NULL;
+	if (previous_manifest) {
+		previous = manifest_find(previous_manifest, rjd_path_get(&job->path_relative));
+	}
+
+	// kept even if the output is rebuilt, so sidecars and fingerprinted copies that aren't rewritten
+	// can be cleaned up
+	entry->sidecars = previous ? previous->sidecars : 0;
+	entry->fingerprint = previous ? previous->fingerprint : 0;
+
+	// Cached for the next run's asset map. Read from the image rather than taken from this run's map,
+	// which --watch doesn't update.
+	entry->image_width = 0;
+	entry->image_height = 0;
+	if (job->type == BUILD_JOB_TYPE_COPY && is_sized_image(rjd_path_get(&job->path_input))) {
+		if (previous && file_stamp_equals(previous->input_stamp, entry->input_stamp) && previous->image_width > 0) {
+			entry->image_width = previous->image_width;
+			entry->image_height = previous->image_height;
+		} else {
+			read_image_size(rjd_path_get(&job->path_input), &entry->image_width, &entry->image_height);
+		}
+	}
+
+	if (previous && file_stamp_equals(previous->input_stamp, entry->input_stamp)) {
+		entry->input_hash = previous->input_hash;
+	} else if (!rjd_result_isok(file_hash(rjd_path_get(&job->path_input), &entry->input_hash, scratch))) {
+		return false;
+	}
+
+	// a fingerprinted copy left behind by --watch is rewritten too, since pages now point at the new one
+	const bool fingerprint_current = job->type != BUILD_JOB_TYPE_COPY || !context->fingerprint || 
+		!is_fingerprinted_asset(rjd_path_get(&job->path_input)) ||
+		(previous && previous->fingerprint == asset_fingerprint(entry->input_hash, entry->template_hash));
+
+	struct file_stamp output_stamp;
+	const bool up_to_date = previous &&
+		previous->input_hash == entry->input_hash &&
+		previous->template_hash == entry->template_hash &&
+		fingerprint_current &&
+		file_stamp_get(rjd_path_get(&job->path_output), &output_stamp);
+	if (up_to_date) {
+		entry->meta = previous->meta;
+	}
+	return up_to_date;
+}
+
+// With --minify, stylesheets are minified as they're copied, and compressed from the minified text
+GEN_INTERNAL void minify_stylesheet(struct build_job* job, const struct build_context* context, struct transform_scratch* scratch)
+{
+	const char* path_input = rjd_path_get(&job->path_input);
+	const char* path_output = rjd_path_get(&job->path_output);
+	rjd_strbuf_append(&job->log, "minify %s -> %s\n", path_input, path_output);
+
+	struct source_file source;
+	struct rjd_result result = source_file_open(&source, path_input, scratch);
+	if (rjd_result_isok(result)) {
+		struct rjd_strbuf* page = &scratch->page;
+		rjd_strbuf_clear(page);
+		minify_css(source.contents, source.size, page);
+		const struct output_span span = { rjd_strbuf_str(page), page->length };
+
+		const uint32_t saved = (uint32_t)(source.size - page->length);
+		scratch->timings.minified_bytes += saved;
+		log_minified(&job->log, saved, page->length);
+		trace_count(scratch->trace, TRACE_COUNTER_BYTES_READ, source.size);
+		trace_count(scratch->trace, TRACE_COUNTER_BYTES_WRITTEN, page->length);
+
+		struct rjd_path folder = rjd_path_init_with(path_output);
+		rjd_path_pop(&folder);
+		rjd_fio_mkdir(rjd_path_get(&folder));
+
+		result = write_output_file(path_output, &span, 1, &scratch->timings);
+		source_file_close(&source);
+		if (rjd_result_isok(result)) {
+			result = write_compressed_sidecars(path_output, &span, 1, &context->compress, &job->manifest_entry.sidecars, scratch);
+		}
+	}
+
+	if (rjd_result_isok(result)) {
+		job->built = true;
+	} else {
+		rjd_strbuf_append(&job->log, "Minify error for file '%s': %s\n", path_input, result.error);
+	}
+}
+
+GEN_INTERNAL void compress_asset(struct build_job* job, const struct build_context* context, struct transform_scratch* scratch)
+{
+	const char* path_input = rjd_path_get(&job->path_input);
+	const char* path_output = rjd_path_get(&job->path_output);
+	uint8_t* sidecars = &job->manifest_entry.sidecars;
+
+	const struct compress_settings no_compression = {0};
+	const struct compress_settings* settings = is_compressible_asset(path_input) ? &context->compress : &no_compression;
+
+	struct rjd_result result = RJD_RESULT_OK();
+	if (compress_settings_any(settings)) {
+		struct source_file source;
+		result = source_file_open(&source, path_input, scratch);
+		if (rjd_result_isok(result)) {
+			const struct output_span span = { source.contents, source.size };
+			result = write_compressed_sidecars(path_output, &span, 1, settings, sidecars, scratch);
+			source_file_close(&source);
+		}
+	} else {
+		// only deletes any sidecars left from a build that compressed
+		result = write_compressed_sidecars(path_output, NULL, 0, settings, sidecars, scratch);
+	}
+
+	if (!rjd_result_isok(result)) {
+		rjd_strbuf_append(&job->log, "Compress error for file '%s': %s\n", path_input, result.error);
+		job->built = false;
+		job->up_to_date = false;
+	}
+}
+
+// suffix is appended after the fingerprinted name, for sidecars
+GEN_INTERNAL struct rjd_path fingerprinted_output_path(const char* path_output, uint64_t fingerprint, const char* suffix)
+{
+	char fingerprinted[RJD_PATH_BUFFER_LENGTH];
+	format_fingerprinted_path(fingerprinted, sizeof(fingerprinted), path_output, strlen(path_output), fingerprint);
+	struct rjd_path path = rjd_path_init_with(fingerprinted);
+	rjd_path_append(&path, suffix);
+	return path;
+}
+
+GEN_INTERNAL void remove_fingerprinted_copy(const char* path_output, uint64_t fingerprint, uint8_t sidecars)
+{
+	struct rjd_path path_fingerprinted = fingerprinted_output_path(path_output, fingerprint, "");
+	remove(rjd_path_get(&path_fingerprinted));
+	for (uint32_t format = 0; format < COMPRESS_FORMAT_COUNT; ++format) {
+		if (sidecars & (1u << format)) {
+			struct rjd_path path_sidecar = fingerprinted_output_path(path_output, fingerprint, COMPRESS_FORMAT_EXTENSIONS[format]);
+			remove(rjd_path_get(&path_sidecar));
+		}
+	}
+}
+
+// Fingerprints and sizes every asset that needs it, reusing the previous manifest's hashes and image
+// sizes for inputs that haven't changed
+GEN_INTERNAL void asset_map_build(struct asset_map* assets, const struct build_job* jobs, const struct build_context* context, 
+	struct transform_scratch* scratch)
+{
+	const uint64_t settings_hash = output_settings_hash(context, 0);
+	for (uint32_t i = 0; i < rjd_array_count(jobs); ++i) {
+		const struct build_job* job = jobs + i;
+		const char* path_input = rjd_path_get(&job->path_input);
+		const char* path_relative = rjd_path_get(&job->path_relative);
+		const bool is_fingerprinted = context->fingerprint && is_fingerprinted_asset(path_input);
+		const bool is_sized = is_sized_image(path_input);
+		if (job->type != BUILD_JOB_TYPE_COPY || !(is_fingerprinted || is_sized)) {
+			continue;
+		}
+
+		struct file_stamp stamp;
+		if (!file_stamp_get(path_input, &stamp)) {
+			continue;
+		}
+		const struct manifest_entry* previous = context->previous_manifest ? manifest_find(context->previous_manifest, path_relative) : NULL;
+		const bool unchanged = previous && file_stamp_equals(previous->input_stamp, stamp);
+
+		struct asset_info info = {0};
+		if (is_fingerprinted) {
+			uint64_t input_hash = 0;
+			if (unchanged) {
+				input_hash = previous->input_hash;
+			} else if (!rjd_result_isok(file_hash(path_input, &input_hash, scratch))) {
+				continue;
+			}
+			info.fingerprint = asset_fingerprint(input_hash, settings_hash);
+		}
+		if (is_sized && unchanged && previous->image_width > 0) {
+			info.width = previous->image_width;
+			info.height = previous->image_height;
+		} else if (is_sized) {
+			read_image_size(path_input, &info.width, &info.height);
+		}
+
+		const struct rjd_hash64 path_hash = rjd_hash64_str(path_relative);
+		rjd_array_push(assets->infos, info);
+		rjd_dict_insert(&assets->lookup, path_hash, (void*)(uintptr_t)rjd_array_count(assets->infos));
+
+		const uint64_t key[] = { assets->hash, path_hash.value, info.fingerprint, info.width, info.height };
+		assets->hash = rjd_hash64_data((const uint8_t*)key, sizeof(key)).value;
+	}
+}
+
+// Links the asset's output and sidecars to its fingerprinted name, removing the copy an earlier build
+// made if the fingerprint has changed. Under --watch the asset map is still the one from the start of
+// the run, and pages point at its fingerprints, so a changed asset keeps its old fingerprinted copy
+// until the next full build.
+GEN_INTERNAL void write_fingerprinted_copy(struct build_job* job, const struct build_context* context, uint64_t previous_fingerprint, uint8_t previous_sidecars)
+{
+	struct manifest_entry* entry = &job->manifest_entry;
+	const char* path_output = rjd_path_get(&job->path_output);
+
+	const struct asset_info* info = context->assets ? asset_map_find(context->assets, rjd_path_get(&job->path_relative)) : NULL;
+	const uint64_t fingerprint = info ? info->fingerprint : 0;
+	if (fingerprint != 0 && fingerprint != asset_fingerprint(entry->input_hash, entry->template_hash)) {
+		rjd_strbuf_append(&job->log, "\tchanged since the asset map was built, so the fingerprinted copy is left as it was\n");
+		entry->fingerprint = previous_fingerprint;
+		return;
+	}
+
+	if (previous_fingerprint != 0 && previous_fingerprint != fingerprint) {
+		remove_fingerprinted_copy(path_output, previous_fingerprint, previous_sidecars);
+	}
+
+	entry->fingerprint = 0;
+	if (fingerprint == 0 || !job->built) {
+		return;
+	}
+
+	// the output, then each sidecar
+	for (uint32_t i = 0; i <= COMPRESS_FORMAT_COUNT; ++i) {
+		const char* suffix = i == 0 ? "" : COMPRESS_FORMAT_EXTENSIONS[i - 1];
+		struct rjd_path path_src = rjd_path_init_with(path_output);
+		rjd_path_append(&path_src, suffix);
+		struct rjd_path path_dst = fingerprinted_output_path(path_output, fingerprint, suffix);
+		if (i > 0 && !(entry->sidecars & (1u << (i - 1)))) {
+			remove(rjd_path_get(&path_dst));
+			continue;
+		}
+
+		enum copy_method method = COPY_METHOD_READ_WRITE;
+		struct rjd_result result = copy_file(rjd_path_get(&path_src), rjd_path_get(&path_dst), true, &method);
+		if (!rjd_result_isok(result)) {
+			rjd_strbuf_append(&job->log, "Fingerprint error for file '%s': %s\n", rjd_path_get(&path_dst), result.error);
+			job->built = false;
+			job->up_to_date = false;
+			return;
+		}
+		if (i == 0) {
+			rjd_strbuf_append(&job->log, "fingerprint %s -> %s (%s)\n", path_output, rjd_path_get(&path_dst), COPY_METHOD_NAMES[method]);
+		}
+	}
+	entry->fingerprint = fingerprint;
+}
+
+GEN_INTERNAL void run_build_job(struct build_job* job, const struct build_context* context, struct transform_scratch* scratch)
+{
+	const char* path_input = rjd_path_get(&job->path_input);
+	const char* path_output = rjd_path_get(&job->path_output);
+
+	double trace_begin = trace_now(scratch->trace);
+	const bool up_to_date = is_build_job_up_to_date(job, context, scratch);
+	trace_begin = trace_scope(scratch->trace, "check manifest", path_input, trace_begin);
+	if (up_to_date) {
+		job->built = true;
+		job->up_to_date = true;
+		return;
+	}
+
+	switch (job->type)
+	{
+		case BUILD_JOB_TYPE_MARKDOWN:
+		{
+			rjd_strbuf_append(&job->log, "transform %s -> %s\n", path_input, path_output);
+
+			struct page_fields fields;
+			page_fields_init(&fields, rjd_path_get(&job->path_relative), rjd_path_get(&job->path_root));
+
+			struct rjd_path page_folder = job->path_relative;
+			rjd_path_pop(&page_folder);
+			const struct render_state render = {
+				.minify = context->minify,
+				.assets = context->assets,
+				.page_folder = rjd_path_get(&page_folder),
+			};
+
+			struct rjd_result r = transform_markdown_file(path_input, path_output, context->page_template, &fields, 
+				&job->manifest_entry.meta, render, &context->compress, &job->manifest_entry.sidecars, scratch, &job->log);
+			if (rjd_result_isok(r) == false) {
+				rjd_strbuf_append(&job->log, "Markdown error in file '%s': %s\n", path_input, r.error);
+			} else {
+				job->built = true;
+			}
+
+			if (context->print_arena_stats) {
+				rjd_strbuf_append(&job->log, "\tarena high water %.1f KB of %.1f KB, document %.1f KB of %.1f KB\n", 
+					scratch->arena.high_water / 1024.0, scratch->arena.capacity / 1024.0,
+					scratch->doc_arena.high_water / 1024.0, scratch->doc_arena.capacity / 1024.0);
+			}
+			trace_scope(scratch->trace, "transform", path_input, trace_begin);
+			break;
+		}
+		case BUILD_JOB_TYPE_COPY:
+		{
+			// from the previous build, until the output is rewritten
+			const uint64_t previous_fingerprint = job->manifest_entry.fingerprint;
+			const uint8_t previous_sidecars = job->manifest_entry.sidecars;
+
+			// minify_stylesheet() writes its own sidecars, compressed from the minified text
+			const bool is_stylesheet_minified = context->minify && rjd_path_str_endswith(path_input, ".css");
+			if (is_stylesheet_minified) {
+				minify_stylesheet(job, context, scratch);
+				trace_scope(scratch->trace, "minify", path_input, trace_begin);
+			} else if (!context->force_rebuild && !context->hardlink_assets && is_copy_destination_current(path_input, path_output, job->manifest_entry.input_hash, scratch)) {
+				job->built = true;
+				job->up_to_date = true;
+			} else {
+				struct rjd_path folder = rjd_path_init_with(path_output);
+				rjd_path_pop(&folder);
+				rjd_fio_mkdir(rjd_path_get(&folder));
+
+				enum copy_method method = COPY_METHOD_READ_WRITE;
+				struct rjd_result r = copy_file(path_input, path_output, context->hardlink_assets, &method);
+				if (rjd_result_isok(r)) {
+					rjd_strbuf_append(&job->log, "copy %s -> %s (%s)\n", path_input, path_output, COPY_METHOD_NAMES[method]);
+					job->built = true;
+					trace_count(scratch->trace, TRACE_COUNTER_BYTES_READ, job->manifest_entry.input_stamp.size);
+					trace_count(scratch->trace, TRACE_COUNTER_BYTES_WRITTEN, job->manifest_entry.input_stamp.size);
+				} else {
+					rjd_strbuf_append(&job->log, "Copy error for file '%s': %s\n", path_input, r.error);
+				}
+				trace_scope(scratch->trace, "copy", path_input, trace_begin);
+			}
+
+			// Done even if the copy was skipped, since without a manifest entry the sidecars are unknown
+			if (job->built && !is_stylesheet_minified) {
+				compress_asset(job, context, scratch);
+			}
+
+			write_fingerprinted_copy(job, context, previous_fingerprint, previous_sidecars);
+			break;
+		}
+	}
+}
+
+GEN_INTERNAL bool job_deque_pop(struct job_deque* deque, uint32_t* out_index)
+{
+	bool found = false;
+	rjd_lock_acquire_writer(&deque->lock);
+	if (rjd_array_count(deque->job_indices) > deque->head) {
+		*out_index = rjd_array_pop(deque->job_indices);
+		found = true;
+	}
+	rjd_lock_release_writer(&deque->lock);
+	return found;
+}
+
+GEN_INTERNAL bool job_deque_steal(struct job_deque* deque, uint32_t* out_index)
+{
+	bool found = false;
+	rjd_lock_acquire_writer(&deque->lock);
+	if (rjd_array_count(deque->job_indices) > deque->head) {
+		*out_index = deque->job_indices[deque->head];
+		++deque->head;
+		found = true;
+	}
+	rjd_lock_release_writer(&deque->lock);
+	return found;
+}
+
+GEN_INTERNAL bool build_worker_next_job(struct build_worker* worker, uint32_t* out_index)
+{
+	if (job_deque_pop(&worker->deque, out_index)) {
+		return true;
+	}
+
+	const struct build_pool* pool = worker->pool;
+	for (uint32_t i = 1; i < pool->worker_count; ++i) {
+		struct build_worker* victim = pool->workers + (worker->index + i) % pool->worker_count;
+		if (job_deque_steal(&victim->deque, out_index)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+GEN_INTERNAL RJD_THREAD_ENTRYPOINT_FUNC(build_worker_main)
+{
+	struct build_worker* worker = userdata;
+	struct build_pool* pool = worker->pool;
+
+	struct transform_scratch scratch = transform_scratch_init(&worker->alloc);
+
+	char thread_name[32];
+	snprintf(thread_name, sizeof(thread_name), "build worker %u", worker->index);
+	scratch.trace = trace_thread_begin(pool->context->trace, thread_name);
+
+	uint32_t job_index = 0;
+	while (build_worker_next_job(worker, &job_index))
+	{
+		struct build_job* job = pool->jobs + job_index;
+		job->log = rjd_strbuf_init(&worker->alloc);
+		run_build_job(job, pool->context, &scratch);
+
+		rjd_lock_acquire_writer(&pool->done_lock);
+		job->done = true;
+		rjd_condvar_signal_all(&pool->done_condvar);
+		rjd_lock_release_writer(&pool->done_lock);
+	}
+
+	worker->arena_high_water = scratch.arena.high_water_max;
+	worker->doc_arena_high_water = scratch.doc_arena.high_water_max;
+	worker->timings = scratch.timings;
+	transform_scratch_free(&scratch);
+}
+
+struct build_stats
+{
+	size_t arena_high_water; // largest of any page
+	size_t doc_arena_high_water;
+	struct transform_timings timings; // summed over all workers
+};
+
+// The log is freed separately, since it belongs to the allocator of the worker that ran the job
+GEN_INTERNAL void print_build_job_log(const struct build_job* job, const struct build_context* context)
+{
+	if (!context->quiet || !job->built) {
+		fputs(rjd_strbuf_str(&job->log), stdout);
+	}
+}
+
+GEN_INTERNAL struct build_stats run_build_jobs(struct build_job* jobs, const struct build_context* context, uint32_t worker_count, struct rjd_mem_allocator* alloc)
+{
+	const uint32_t job_count = rjd_array_count(jobs);
+	struct build_stats stats = {0};
+
+	if (worker_count <= 1) {
+		struct transform_scratch scratch = transform_scratch_init(alloc);
+		scratch.trace = context->trace_main;
+		for (uint32_t i = 0; i < job_count; ++i) {
+			jobs[i].log = rjd_strbuf_init(alloc);
+			run_build_job(jobs + i, context, &scratch);
+			print_build_job_log(jobs + i, context);
+			rjd_strbuf_free(&jobs[i].log);
+		}
+		stats.arena_high_water = scratch.arena.high_water_max;
+		stats.doc_arena_high_water = scratch.doc_arena.high_water_max;
+		stats.timings = scratch.timings;
+		transform_scratch_free(&scratch);
+		return stats;
+	}
+
+	struct build_pool pool =
+	{
+		.context = context,
+		.jobs = jobs,
+		.workers = rjd_mem_alloc_array(struct build_worker, worker_count, alloc),
+		.worker_count = worker_count,
+	};
+	rjd_lock_init(&pool.done_lock);
+	rjd_condvar_init(&pool.done_condvar);
+
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		struct build_worker* worker = pool.workers + i;
+		worker->pool = &pool;
+		worker->index = i;
+		worker->alloc = rjd_mem_allocator_init_default();
+		worker->deque.job_indices = rjd_array_alloc(uint32_t, job_count / worker_count + 1, alloc);
+		worker->deque.head = 0;
+		rjd_lock_init(&worker->deque.lock);
+	}
+
+	// deal in reverse so each worker pops its jobs in roughly enumeration order, which keeps
+	// the main thread's in-order log printing from stalling on the last file
+	for (uint32_t i = job_count; i > 0; --i) {
+		struct build_worker* worker = pool.workers + (i - 1) % worker_count;
+		rjd_array_push(worker->deque.job_indices, i - 1);
+	}
+
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		struct rjd_thread_desc desc = {
+			.entrypoint_func = build_worker_main,
+			.allocator = alloc,
+			.userdata = pool.workers + i,
+			.optional_name = "build_worker",
+		};
+		struct rjd_result r = rjd_thread_create(&pool.workers[i].thread, desc);
+		RJD_ASSERTMSG(rjd_result_isok(r), "Failed to create worker thread: %s", r.error);
+	}
+
+	// Print each job's log in enumeration order as soon as it's done
+	for (uint32_t i = 0; i < job_count; ++i) {
+		rjd_lock_acquire_writer(&pool.done_lock);
+		while (!jobs[i].done) {
+			rjd_condvar_wait(&pool.done_condvar, &pool.done_lock);
+		}
+		rjd_lock_release_writer(&pool.done_lock);
+
+		print_build_job_log(jobs + i, context);
+	}
+
+	// Workers may still be looking through each other's deques, so join them all before freeing any
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		rjd_thread_join(&pool.workers[i].thread);
+	}
+
+	// and until then they're still allocating from the allocators the logs came from
+	for (uint32_t i = 0; i < job_count; ++i) {
+		rjd_strbuf_free(&jobs[i].log);
+	}
+
+	for (uint32_t i = 0; i < worker_count; ++i) {
+		stats.arena_high_water = rjd_math_max_sizet(stats.arena_high_water, pool.workers[i].arena_high_water);
+		stats.doc_arena_high_water = rjd_math_max_sizet(stats.doc_arena_high_water, pool.workers[i].doc_arena_high_water);
+		transform_timings_add(&stats.timings, &pool.workers[i].timings);
+		rjd_array_free(pool.workers[i].deque.job_indices);
+		rjd_lock_deinit(&pool.workers[i].deque.lock);
+	}
+
+	rjd_condvar_deinit(&pool.done_condvar);
+	rjd_lock_deinit(&pool.done_lock);
+	rjd_mem_free(pool.workers);
+
+	return stats;
+}
+
+// Pages in dated folders are blog posts. After every build, the blog index and RSS feed are
+// generated from the posts' manifest entries, so nothing is read twice and the index can't drift
+// from the posts. The index replaces any blog.md in the source folder, and the feed any rss.xml.
+#define SITE_URL "https://rdunnington.github.io"
+#define SITE_FEED_TITLE "Reuben Dunnington's Blog"
+#define SITE_FEED_DESCRIPTION "Reuben Dunnington's personal website and technical/opinion blog."
+#define SITE_BLOG_INDEX_NAME "blog.md" // rendered as if it were this markdown file in the source folder
+#define SITE_BLOG_INDEX_TITLE "Blog"
+#define SITE_FEED_NAME "rss.xml"
+
+// Newest first
+GEN_INTERNAL int compare_posts(const void* a, const void* b)
+{
+	const struct manifest_entry* post_a = *(const struct manifest_entry* const*)a;
+	const struct manifest_entry* post_b = *(const struct manifest_entry* const*)b;
+	const int order = strcmp(post_b->meta.date, post_a->meta.date);
+	return order ? order : strcmp(rjd_path_get(&post_a->path_output), rjd_path_get(&post_b->path_output));
+}
+
+// 2020-09-03 is written 2020-9-3
+GEN_INTERNAL void append_post_date(struct rjd_strbuf* out, const char* date)
+{
+	rjd_strbuf_append(out, "%.4s-%d-%d", date, atoi(date + 5), atoi(date + 8));
+}
+
+// Renders the index into scratch->page, with spans in page order like render_markdown_page().
+// path_relative and path_root are the index's as if it were a page at SITE_BLOG_INDEX_NAME.
+GEN_INTERNAL void render_blog_index(const struct manifest_entry** posts, const char* path_relative, const char* path_root, 
+	const struct page_template* template, bool minify, struct transform_scratch* scratch, struct output_span spans[3])
+{
+	const uint32_t post_count = rjd_array_count(posts);
+
+	// Every string goes in one buffer before any node points into it, since appending can move it.
+	// bounds[i] is where string i starts: the title, then each post's href and link text.
+	struct rjd_strbuf text = rjd_strbuf_init(scratch->alloc);
+	uint32_t* bounds = rjd_array_alloc(uint32_t, post_count * 2 + 2, scratch->alloc);
+
+	rjd_array_push(bounds, text.length);
+	rjd_strbuf_append(&text, SITE_BLOG_INDEX_TITLE);
+	for (uint32_t i = 0; i < post_count; ++i) {
+		struct rjd_path href = posts[i]->path_output;
+		rjd_path_pop_extension(&href);
+		rjd_array_push(bounds, text.length);
+		rjd_strbuf_append(&text, "/%s", rjd_path_get(&href));
+
+		rjd_array_push(bounds, text.length);
+		append_post_date(&text, posts[i]->meta.date);
+		rjd_strbuf_append(&text, ": %s", posts[i]->meta.title);
+	}
+	rjd_array_push(bounds, text.length);
+
+	const char* str = rjd_strbuf_str(&text);
+	#define GEN_INDEX_STRING(i) str + bounds[i], bounds[(i) + 1] - bounds[i]
+
+	// header and its text, the list, then an item, spacer, link, and link text per post
+	const uint32_t capacity = 3 + post_count * 4;
+	struct rjd_mem_allocator* doc_alloc = page_arena_begin(&scratch->doc_arena, document_memory_required(capacity));
+	struct document doc = document_init(capacity, doc_alloc);
+
+	const uint32_t header = document_open(&doc, DOC_NODE_HEADER, 1, 1);
+	document_text(&doc, DOC_NODE_TEXT, GEN_INDEX_STRING(0));
+	document_close(&doc, header);
+
+	const uint32_t list = document_open(&doc, DOC_NODE_LIST, 1, 0);
+	for (uint32_t i = 0; i < post_count; ++i) {
+		const uint32_t item = document_open(&doc, DOC_NODE_LIST_ITEM, 2, 0);
+		document_text(&doc, DOC_NODE_TEXT, " ", 1);
+
+		const uint32_t link = document_open(&doc, DOC_NODE_LINK, 0, 0);
+		doc.texts[link] = str + bounds[i * 2 + 1];
+		doc.lengths[link] = bounds[i * 2 + 2] - bounds[i * 2 + 1];
+		document_text(&doc, DOC_NODE_TEXT, GEN_INDEX_STRING(i * 2 + 2));
+		document_close(&doc, link);
+
+		document_close(&doc, item);
+	}
+	document_close(&doc, list);
+
+	struct page_fields fields;
+	page_fields_init(&fields, path_relative, path_root);
+	page_fields_set(&fields, PAGE_FIELD_TITLE, GEN_INDEX_STRING(0));
+	#undef GEN_INDEX_STRING
+
+	// rendered body first like transform_markdown_file(), since the header's {{style}} depends on it
+	struct rjd_strbuf* page = &scratch->page;
+	rjd_strbuf_clear(page);
+	struct render_state render = { .minify = minify };
+	render_document(&doc, &render, page);
+	page_arena_end(&scratch->doc_arena);
+
+	const uint32_t body_end = page->length;
+	if (template->critical_css) {
+		critical_css_select(template->critical_css, rjd_strbuf_str(page), body_end, &scratch->style);
+		fields.style = rjd_strbuf_str(&scratch->style);
+		fields.style_length = scratch->style.length;
+	}
+	page_template_render(template, 0, template->body_op, &fields, page);
+	const uint32_t header_end = page->length;
+	page_template_render(template, template->body_op + 1, rjd_array_count(template->ops), &fields, page);
+
+	const char* page_str = rjd_strbuf_str(page);
+	spans[0] = (struct output_span){ page_str + body_end, header_end - body_end };
+	spans[1] = (struct output_span){ page_str, body_end };
+	spans[2] = (struct output_span){ page_str + header_end, page->length - header_end };
+
+	rjd_array_free(bounds);
+	rjd_strbuf_free(&text);
+}
+
+GEN_INTERNAL struct rjd_result write_blog_index(const struct manifest_entry** posts, const char* path_source, const char* path_destination, 
+	const struct page_template* template, bool minify, const struct compress_settings* compress, struct transform_scratch* scratch)
+{
+	// Paths and page fields come out the same as they would for a real blog.md
+	struct rjd_path path_input = rjd_path_init_with(path_source);
+	rjd_path_join_str(&path_input, SITE_BLOG_INDEX_NAME);
+	const struct build_job job = build_job_init(rjd_path_get(&path_input), path_source, path_destination);
+
+	struct output_span spans[3];
+	render_blog_index(posts, rjd_path_get(&job.path_relative), rjd_path_get(&job.path_root), template, minify, scratch, spans);
+
+	// The index isn't in the manifest, so any sidecar it could have is cleaned up if compression is off
+	struct rjd_result result = write_output_file(rjd_path_get(&job.path_output), spans, rjd_countof(spans), &scratch->timings);
+	uint8_t sidecars = COMPRESS_FORMAT_ALL_BITS;
+	if (rjd_result_isok(result)) {
+		result = write_compressed_sidecars(rjd_path_get(&job.path_output), spans, rjd_countof(spans), compress, &sidecars, scratch);
+	}
+	return result;
+}
+
+// 0 is Sunday
+GEN_INTERNAL int day_of_week(int year, int month, int day)
+{
+	static const int month_offsets[] = { 0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4 };
+	year -= month < 3;
+	return (year + year / 4 - year / 100 + year / 400 + month_offsets[month - 1] + day) % 7;
+}
+
+// Replaces what's in out
+GEN_INTERNAL void render_feed(const struct manifest_entry** posts, struct rjd_strbuf* out)
+{
+	static const char* day_names[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	static const char* month_names[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+	rjd_strbuf_clear(out);
+	rjd_strbuf_append(out, "<?xml version=\"1.0\"?>\n");
+	rjd_strbuf_append(out, "<rss version=\"2.0\" xmlns:atom=\"http://www.w3.org/2005/Atom\">\n");
+	rjd_strbuf_append(out, "\t<channel>\n");
+	rjd_strbuf_append(out, "\t\t<title>");
+	append_html_escaped(out, SITE_FEED_TITLE, strlen(SITE_FEED_TITLE));
+	rjd_strbuf_append(out, "</title>\n");
+	rjd_strbuf_append(out, "\t\t<link>" SITE_URL "</link>\n");
+	rjd_strbuf_append(out, "\t\t<atom:link href=\"" SITE_URL "/" SITE_FEED_NAME "\" rel=\"self\" type=\"application/rss+xml\" />\n");
+	rjd_strbuf_append(out, "\t\t<description>");
+	append_html_escaped(out, SITE_FEED_DESCRIPTION, strlen(SITE_FEED_DESCRIPTION));
+	rjd_strbuf_append(out, "</description>\n");
+	rjd_strbuf_append(out, "\t\t<language>en-us</language>\n");
+
+	for (uint32_t i = 0; i < rjd_array_count(posts); ++i) {
+		const struct page_meta* meta = &posts[i]->meta;
+		const char* path = rjd_path_get(&posts[i]->path_output);
+
+		const int year = atoi(meta->date);
+		const int month = rjd_math_max_i32(1, rjd_math_min_i32(atoi(meta->date + 5), 12));
+		const int day = atoi(meta->date + 8);
+
+		rjd_strbuf_append(out, "\t\t<item>\n");
+		rjd_strbuf_append(out, "\t\t\t<title>");
+		append_html_escaped(out, meta->title, strlen(meta->title));
+		rjd_strbuf_append(out, "</title>\n");
+		rjd_strbuf_append(out, "\t\t\t<description>");
+		append_html_escaped(out, meta->summary, strlen(meta->summary));
+		rjd_strbuf_append(out, "</description>\n");
+		rjd_strbuf_append(out, "\t\t\t<link>" SITE_URL "/%s</link>\n", path);
+		rjd_strbuf_append(out, "\t\t\t<guid>" SITE_URL "/%s</guid>\n", path);
+		rjd_strbuf_append(out, "\t\t\t<pubDate>%s, %d %s %d 12:00:00 PDT</pubDate>\n", 
+			day_names[day_of_week(year, month, day)], day, month_names[month - 1], year);
+		rjd_strbuf_append(out, "\t\t</item>\n");
+	}
+
+	rjd_strbuf_append(out, "\t</channel>\n");
+	rjd_strbuf_append(out, "</rss>\n");
+}
+
+GEN_INTERNAL struct rjd_result write_feed(const struct manifest_entry** posts, const char* path_destination, const struct compress_settings* compress, 
+	struct transform_scratch* scratch)
+{
+	struct rjd_strbuf* out = &scratch->page;
+	render_feed(posts, out);
+
+	struct rjd_path path_feed = rjd_path_init_with(path_destination);
+	rjd_path_join_str(&path_feed, SITE_FEED_NAME);
+	const struct output_span span = { rjd_strbuf_str(out), out->length };
+	RJD_RESULT_PROMOTE(write_output_file(rjd_path_get(&path_feed), &span, 1, &scratch->timings));
+
+	uint8_t sidecars = COMPRESS_FORMAT_ALL_BITS;
+	return write_compressed_sidecars(rjd_path_get(&path_feed), &span, 1, compress, &sidecars, scratch);
+}
+
+// Does nothing for a site without posts. post_count is how many were indexed, and the files it
+// writes are counted into timings.
+GEN_INTERNAL struct rjd_result write_site_index(const struct manifest* manifest, const char* path_source, const char* path_destination, 
+	const struct page_template* template, bool minify, const struct compress_settings* compress, uint32_t* post_count, 
+	struct transform_timings* timings, struct rjd_mem_allocator* alloc)
+{
+	const struct manifest_entry** posts = rjd_array_alloc(const struct manifest_entry*, 64, alloc);
+	for (uint32_t i = 0; i < rjd_array_count(manifest->entries); ++i) {
+		if (manifest->entries[i].meta.date[0] != '\0') {
+			rjd_array_push(posts, manifest->entries + i);
+		}
+	}
+
+	*post_count = rjd_array_count(posts);
+	struct rjd_result result = RJD_RESULT_OK();
+	if (*post_count > 0) {
+		qsort(posts, *post_count, sizeof(*posts), compare_posts);
+
+		struct transform_scratch scratch = transform_scratch_init(alloc);
+		result = write_blog_index(posts, path_source, path_destination, template, minify, compress, &scratch);
+		if (rjd_result_isok(result)) {
+			result = write_feed(posts, path_destination, compress, &scratch);
+		}
+		transform_timings_add(timings, &scratch.timings);
+		transform_scratch_free(&scratch);
+	}
+
+	rjd_array_free(posts);
+	return result;
+}
+
+#if defined(__linux__)
+
+// After the first change in a burst, wait until the tree has been quiet this long before
+// rebuilding. Editors often save with several writes and renames in quick succession.
+#define GEN_WATCH_DEBOUNCE_MS 5
+#define GEN_WATCH_EVENT_MASK (IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+struct watched_folder
+{
+	int descriptor;
+	struct rjd_path path;
+};
+
+struct site_watcher
+{
+	int fd;
+	struct watched_folder* folders;
+	struct rjd_path* changed_paths; // input files and folders touched since the last rebuild
+	struct rjd_timer first_change;
+};
+
+GEN_INTERNAL void site_watcher_mark_changed(struct site_watcher* watcher, const char* path)
+{
+	if (rjd_array_empty(watcher->changed_paths)) {
+		watcher->first_change = rjd_timer_init();
+	}
+
+	for (uint32_t i = 0; i < rjd_array_count(watcher->changed_paths); ++i) {
+		if (!strcmp(rjd_path_get(watcher->changed_paths + i), path)) {
+			return;
 		}
+	}
 
-		t = stream->tokens + stream->cursor;
-		if (t->type == TOKEN_TYPE_ANGLE_BRACKET_CLOSE) {
-			rjd_strbuf_append(out, "<br>");
+	struct rjd_path changed = rjd_path_init_with(path);
+	rjd_array_push(watcher->changed_paths, changed);
+}
+
+// inotify isn't recursive, so every folder in the tree gets its own watch
+GEN_INTERNAL void site_watcher_add_tree(struct site_watcher* watcher, const char* path_folder, struct rjd_mem_allocator* alloc)
+{
+	int descriptor = inotify_add_watch(watcher->fd, path_folder, GEN_WATCH_EVENT_MASK);
+	if (descriptor < 0) {
+		printf("Failed to watch '%s': %s\n", path_folder, strerror(errno));
+		return;
+	}
+
+	struct watched_folder folder = { .descriptor = descriptor, .path = rjd_path_init_with(path_folder) };
+	rjd_array_push(watcher->folders, folder);
+
+	struct rjd_path_enumerator_state path_walker = rjd_path_enumerate_create(path_folder, alloc, RJD_PATH_ENUMERATE_MODE_RECURSIVE);
+	for (const char* path = rjd_path_enumerate_next(&path_walker); path != NULL; path = rjd_path_enumerate_next(&path_walker)) {
+		enum rjd_fio_attributes attribs = 0;
+		if (rjd_result_isok(rjd_fio_attributes_get(path, &attribs)) && (attribs & RJD_FIO_ATTRIBUTES_DIRECTORY)) {
+			descriptor = inotify_add_watch(watcher->fd, path, GEN_WATCH_EVENT_MASK);
+			if (descriptor >= 0) {
+				struct watched_folder subfolder = { .descriptor = descriptor, .path = rjd_path_init_with(path) };
+				rjd_array_push(watcher->folders, subfolder);
+			}
 		}
 	}
+	rjd_path_enumerate_destroy(&path_walker);
+}
 
-	rjd_strbuf_append(out, "</p>\n");
+GEN_INTERNAL bool path_is_within(const char* path, const char* folder)
+{
+	const size_t length = strlen(folder);
+	return !strncmp(path, folder, length) && (path[length] == '\0' || path[length] == '/');
+}
 
-	return RJD_RESULT_OK();
+// A folder moved out of the tree keeps its watches, so they have to be dropped by hand
+GEN_INTERNAL void site_watcher_forget_tree(struct site_watcher* watcher, const char* path_folder)
+{
+	for (uint32_t i = rjd_array_count(watcher->folders); i > 0; --i) {
+		struct watched_folder* folder = watcher->folders + i - 1;
+		if (path_is_within(rjd_path_get(&folder->path), path_folder)) {
+			inotify_rm_watch(watcher->fd, folder->descriptor);
+			rjd_array_erase_unordered(watcher->folders, i - 1);
+		}
+	}
 }
 
-struct rjd_result parse_code(struct rjd_strbuf* out, struct token_stream* stream, enum paragraph_position paragraph_position)
+GEN_INTERNAL void site_watcher_read_events(struct site_watcher* watcher, const char* path_source, struct rjd_mem_allocator* alloc)
 {
-	const struct token* t = stream->tokens + stream->cursor;
-	RJD_ASSERT(t->type == TOKEN_TYPE_BACKTICK);
+	_Alignas(struct inotify_event) char buffer[16 * 1024];
 
-	const struct rjd_result result_missing_multiline_token = RJD_RESULT("Multiline token is 3 backticks on its own line, with an optional (unused) language text token.");
+	for (;;)
+	{
+		ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			return;
+		}
 
-	bool multiline = false;
-	if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
-		advance_token(stream);
-		if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
-			advance_token(stream);
+		for (const char* next = buffer; next < buffer + length; ) {
+			const struct inotify_event* event = (const struct inotify_event*)next;
+			next += sizeof(struct inotify_event) + event->len;
 
-			// consume optional language token
-			if (peek_token(stream, TOKEN_TYPE_TEXT)) {
-				advance_token(stream);
+			// Events were dropped, so anything in the tree could have changed
+			if (event->mask & IN_Q_OVERFLOW) {
+				site_watcher_mark_changed(watcher, path_source);
+				continue;
 			}
 
-			if (peek_token(stream, TOKEN_TYPE_NEWLINE)) {
-				advance_token(stream);
-				multiline = true;
-			} else {
-				return result_missing_multiline_token;
+			const struct watched_folder* folder = NULL;
+			uint32_t folder_index = 0;
+			for (; folder_index < rjd_array_count(watcher->folders); ++folder_index) {
+				if (watcher->folders[folder_index].descriptor == event->wd) {
+					folder = watcher->folders + folder_index;
+					break;
+				}
+			}
+
+			if (folder == NULL) {
+				continue;
+			}
+
+			if (event->mask & IN_IGNORED) {
+				rjd_array_erase_unordered(watcher->folders, folder_index);
+				continue;
+			}
+
+			if (event->len == 0) {
+				continue;
+			}
+
+			struct rjd_path path = folder->path;
+			rjd_path_join_str(&path, event->name);
+
+			if (event->mask & IN_ISDIR) {
+				if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+					site_watcher_add_tree(watcher, rjd_path_get(&path), alloc);
+				} else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+					site_watcher_forget_tree(watcher, rjd_path_get(&path));
+				}
+			}
+
+			site_watcher_mark_changed(watcher, rjd_path_get(&path));
+		}
+	}
+}
+
+// Deletes the output, its sidecars, its fingerprinted copy, and any folders it leaves empty,
+// stopping at the output root
+GEN_INTERNAL void remove_output_file(const char* path_output, uint8_t sidecars, uint64_t fingerprint, const char* path_destination)
+{
+	if (unlink(path_output) != 0) {
+		return;
+	}
+
+	if (fingerprint != 0) {
+		remove_fingerprinted_copy(path_output, fingerprint, sidecars);
+	}
+
+	for (uint32_t format = 0; format < COMPRESS_FORMAT_COUNT; ++format) {
+		if (sidecars & (1u << format)) {
+			struct rjd_path path_sidecar = rjd_path_init_with(path_output);
+			rjd_path_append(&path_sidecar, COMPRESS_FORMAT_EXTENSIONS[format]);
+			unlink(rjd_path_get(&path_sidecar));
+		}
+	}
+
+	struct rjd_path folder = rjd_path_init_with(path_output);
+	rjd_path_pop(&folder);
+	while (folder.length > strlen(path_destination) && rmdir(rjd_path_get(&folder)) == 0) {
+		rjd_path_pop(&folder);
+	}
+}
+
+struct watch_paths
+{
+	const char* source;
+	const char* destination;
+	const char* manifest;
+};
+
+// Builds anything that still exists under the changed paths and removes the outputs of
+// anything that doesn't. The manifest is updated in place and rewritten.
+GEN_INTERNAL void rebuild_changed_paths(struct site_watcher* watcher, const struct watch_paths* paths, struct manifest* manifest, 
+	struct build_context context, uint32_t worker_count, struct rjd_mem_allocator* alloc)
+{
+	struct build_job* jobs = rjd_array_alloc(struct build_job, 16, alloc);
+	struct rjd_dict queued = rjd_dict_init(alloc, 16);
+	uint32_t removed_count = 0;
+
+	for (uint32_t i = 0; i < rjd_array_count(watcher->changed_paths); ++i) {
+		const char* path_changed = rjd_path_get(watcher->changed_paths + i);
+
+		enum rjd_fio_attributes attribs = 0;
+		if (!rjd_result_isok(rjd_fio_attributes_get(path_changed, &attribs))) {
+			// Gone, so drop every output that came from this path or from inside it if it was a folder
+			const struct build_job gone = build_job_init(path_changed, paths->source, paths->destination);
+			struct rjd_path prefix = rjd_path_init_with(path_changed);
+			rjd_path_pop_front_path_str(&prefix, paths->source);
+
+			for (uint32_t j = rjd_array_count(manifest->entries); j > 0; --j) {
+				const char* path_output = rjd_path_get(&manifest->entries[j - 1].path_output);
+				if (!strcmp(path_output, rjd_path_get(&gone.path_relative)) || path_is_within(path_output, rjd_path_get(&prefix))) {
+					struct rjd_path path_absolute = rjd_path_init_with(path_output);
+					rjd_path_join_front(&path_absolute, paths->destination);
+					remove_output_file(rjd_path_get(&path_absolute), manifest->entries[j - 1].sidecars, 
+						manifest->entries[j - 1].fingerprint, paths->destination);
+					printf("remove %s\n", rjd_path_get(&path_absolute));
+
+					manifest_remove(manifest, path_output);
+					++removed_count;
+				}
+			}
+			continue;
+		}
+
+		struct rjd_path_enumerator_state path_walker = {0};
+		const bool is_folder = (attribs & RJD_FIO_ATTRIBUTES_DIRECTORY) != 0;
+		if (is_folder) {
+			path_walker = rjd_path_enumerate_create(path_changed, alloc, RJD_PATH_ENUMERATE_MODE_RECURSIVE);
+		}
+
+		for (const char* path_input = is_folder ? rjd_path_enumerate_next(&path_walker) : path_changed;
+			path_input != NULL;
+			path_input = is_folder ? rjd_path_enumerate_next(&path_walker) : NULL)
+		{
+			if (!rjd_result_isok(rjd_fio_attributes_get(path_input, &attribs)) || (attribs & RJD_FIO_ATTRIBUTES_DIRECTORY)) {
+				continue;
+			}
+
+			if (RJD_PLATFORM_OSX && strstr(path_input, "DS_Store")) {
+				continue;
+			}
+
+			// A folder and a file inside it can both be in the change list
+			const struct rjd_hash64 hash = rjd_hash64_str(path_input);
+			if (rjd_dict_get(&queued, hash)) {
+				continue;
 			}
+			rjd_dict_insert(&queued, hash, (void*)1);
+
+			struct build_job job = build_job_init(path_input, paths->source, paths->destination);
+			rjd_array_push(jobs, job);
+		}
+
+		if (is_folder) {
+			rjd_path_enumerate_destroy(&path_walker);
+		}
+	}
+
+	rjd_array_clear(watcher->changed_paths);
+
+	// Unchanged files are still caught by the manifest, e.g. a save without edits
+	context.previous_manifest = manifest;
+	const uint32_t job_count = rjd_array_count(jobs);
+	struct build_stats stats = run_build_jobs(jobs, &context, worker_count < job_count ? worker_count : job_count, alloc);
+
+	uint32_t updated_count = 0;
+	for (uint32_t i = 0; i < job_count; ++i) {
+		if (jobs[i].built) {
+			manifest_add(manifest, &jobs[i].manifest_entry);
+			updated_count += jobs[i].up_to_date ? 0 : 1;
 		} else {
-			return result_missing_multiline_token;
+			manifest_remove(manifest, rjd_path_get(&jobs[i].path_relative));
 		}
 	}
 
-	if (multiline) {
-		append_indent(out, stream);
-		rjd_strbuf_append(out, "<pre><code>");
-	} else if (paragraph_position == PARAGRAPH_POSITION_ROOT) {
-		// this is an inline code block, but we haven't started a paragraph yet, so start one
-		// now and let the inner parsing code recurse into this function
-		return parse_paragraph(out, stream);
+	struct rjd_result manifest_result = manifest_write(manifest, paths->manifest, alloc);
+	if (!rjd_result_isok(manifest_result)) {
+		printf("Failed to write manifest '%s': %s\n", paths->manifest, manifest_result.error);
+	}
+
+	uint32_t post_count = 0;
+	struct rjd_result index_result = write_site_index(manifest, paths->source, paths->destination, context.page_template, context.minify, 
+		&context.compress, &post_count, &stats.timings, alloc);
+	if (!rjd_result_isok(index_result)) {
+		printf("Failed to write the blog index: %s\n", index_result.error);
+	}
+
+	printf("Updated %u file(s) and removed %u, rewriting %" PRIu64 " output(s) and leaving %" PRIu64 " unchanged, %.2f ms after the first change\n", 
+		updated_count, removed_count, stats.timings.rewritten_files, stats.timings.unchanged_files, 
+		rjd_timer_elapsed(&watcher->first_change) * 1000.0);
+	fflush(stdout);
+
+	rjd_dict_free(&queued);
+	rjd_array_free(jobs);
+}
+
+// Keeps the build resident, rebuilding only what changed under the source folder. Runs until killed.
+GEN_INTERNAL struct rjd_result watch_site(const struct watch_paths* paths, struct manifest* manifest, const struct build_context* context, 
+	uint32_t worker_count, struct rjd_mem_allocator* alloc)
+{
+	struct site_watcher watcher = {
+		.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC),
+		.folders = rjd_array_alloc(struct watched_folder, 64, alloc),
+		.changed_paths = rjd_array_alloc(struct rjd_path, 16, alloc),
+	};
+
+	struct rjd_result result = RJD_RESULT_OK();
+	if (watcher.fd < 0) {
+		result = RJD_RESULT("Failed to initialize inotify");
 	} else {
-		RJD_ASSERT(paragraph_position == PARAGRAPH_POSITION_INLINE);
-		rjd_strbuf_append(out, "<span class=\"inline-code\">");
+		site_watcher_add_tree(&watcher, paths->source, alloc);
+		printf("Watching %s for changes...\n", paths->source);
+		fflush(stdout);
 	}
 
-	RJD_RESULT_PROMOTE(advance_token(stream));
-	t = stream->tokens + stream->cursor;
+	while (rjd_result_isok(result))
+	{
+		struct pollfd poll_fd = { .fd = watcher.fd, .events = POLLIN };
+		const int timeout = rjd_array_empty(watcher.changed_paths) ? -1 : GEN_WATCH_DEBOUNCE_MS;
+
+		int ready = poll(&poll_fd, 1, timeout);
+		if (ready < 0) {
+			if (errno != EINTR) {
+				result = RJD_RESULT("Failed waiting for inotify events");
+			}
+		} else if (ready > 0) {
+			site_watcher_read_events(&watcher, paths->source, alloc);
+		} else {
+			rebuild_changed_paths(&watcher, paths, manifest, *context, worker_count, alloc);
+		}
+	}
+
+	if (watcher.fd >= 0) {
+		close(watcher.fd);
+	}
+	rjd_array_free(watcher.changed_paths);
+	rjd_array_free(watcher.folders);
+
+	return result;
+}
+
+// --serve renders pages when they're first requested and serves them from memory, so previewing
+// never writes to an output folder. It's HTTP/1.1 on localhost, with keep-alive and ETags so a
+// reload only sends what changed.
+#define GEN_SERVE_REQUEST_CAPACITY (16 * 1024)
+#define GEN_SERVE_MAX_EVENTS 64
+
+struct serve_content_type
+{
+	const char* extension;
+	const char* type;
+};
+
+GEN_INTERNAL const struct serve_content_type SERVE_CONTENT_TYPES[] =
+{
+	{ ".html", "text/html; charset=utf-8" },
+	{ ".css", "text/css; charset=utf-8" },
+	{ ".js", "text/javascript; charset=utf-8" },
+	{ ".mjs", "text/javascript; charset=utf-8" },
+	{ ".json", "application/json" },
+	{ ".xml", "application/xml" },
+	{ ".txt", "text/plain; charset=utf-8" },
+	{ ".svg", "image/svg+xml" },
+	{ ".png", "image/png" },
+	{ ".jpg", "image/jpeg" },
+	{ ".jpeg", "image/jpeg" },
+	{ ".gif", "image/gif" },
+	{ ".webp", "image/webp" },
+	{ ".ico", "image/x-icon" },
+	{ ".woff", "font/woff" },
+	{ ".woff2", "font/woff2" },
+	{ ".pdf", "application/pdf" },
+};
+
+GEN_INTERNAL const char* serve_content_type(const char* path)
+{
+	for (uint32_t i = 0; i < rjd_countof(SERVE_CONTENT_TYPES); ++i) {
+		if (rjd_path_str_endswith(path, SERVE_CONTENT_TYPES[i].extension)) {
+			return SERVE_CONTENT_TYPES[i].type;
+		}
+	}
+	return "application/octet-stream";
+}
+
+enum serve_target_type
+{
+	SERVE_TARGET_NOT_FOUND,
+	SERVE_TARGET_PAGE,
+	SERVE_TARGET_ASSET,
+	SERVE_TARGET_FOLDER, // redirected to the url with a trailing slash, so the page's relative links work
+};
+
+struct serve_target
+{
+	enum serve_target_type type;
+	struct rjd_path path_input;
+	struct rjd_path path_relative; // where a build would write the page, for its fields
+	struct file_stamp stamp;
+};
+
+// Returns false unless the path is a file or folder
+GEN_INTERNAL bool serve_stat(const char* path, struct file_stamp* stamp, bool* is_folder)
+{
+	struct stat info;
+	if (stat(path, &info) != 0 || !(S_ISREG(info.st_mode) || S_ISDIR(info.st_mode))) {
+		return false;
+	}
+	stamp->size = (uint64_t)info.st_size;
+	stamp->mtime_ns = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+	*is_folder = S_ISDIR(info.st_mode);
+	return true;
+}
+
+// Finds the source file of a url path, reversing how build_job_init() names outputs: page.html
+// and a folder's index.html are rendered from their .md, and so is a url without an extension, as
+// GitHub Pages serves page.html for /page. Anything else is an asset at the same path.
+GEN_INTERNAL struct serve_target serve_resolve(const char* path_source, const char* url_path)
+{
+	struct serve_target target = { .type = SERVE_TARGET_NOT_FOUND };
+
+	// leaves room for the source folder and the extensions swapped in below
+	if (strlen(path_source) + strlen(url_path) + 16 >= RJD_PATH_BUFFER_LENGTH) {
+		return target;
+	}
+
+	const bool is_folder_url = url_path[0] == '\0' || rjd_path_str_endswith(url_path, "/");
+	target.path_relative = rjd_path_init_with(url_path);
+	if (is_folder_url) {
+		rjd_path_append(&target.path_relative, "index.html");
+	}
+	const char* path_relative = rjd_path_get(&target.path_relative);
+
+	bool is_folder = false;
+	if (rjd_path_str_endswith(path_relative, ".html")) {
+		target.path_input = rjd_path_init_with(path_source);
+		rjd_path_join_str(&target.path_input, path_relative);
+		rjd_path_pop_extension(&target.path_input);
+		rjd_path_append(&target.path_input, ".md");
+		if (serve_stat(rjd_path_get(&target.path_input), &target.stamp, &is_folder) && !is_folder) {
+			target.type = SERVE_TARGET_PAGE;
+			return target;
+		}
+	}
+
+	target.path_input = rjd_path_init_with(path_source);
+	rjd_path_join_str(&target.path_input, path_relative);
+	if (serve_stat(rjd_path_get(&target.path_input), &target.stamp, &is_folder)) {
+		target.type = is_folder ? SERVE_TARGET_FOLDER : SERVE_TARGET_ASSET;
+		return target;
+	}
+
+	const char* name = strrchr(path_relative, '/');
+	name = name ? name + 1 : path_relative;
+	if (!is_folder_url && strchr(name, '.') == NULL) {
+		rjd_path_append(&target.path_input, ".md");
+		if (serve_stat(rjd_path_get(&target.path_input), &target.stamp, &is_folder) && !is_folder) {
+			rjd_path_append(&target.path_relative, ".html");
+			target.type = SERVE_TARGET_PAGE;
+		}
+	}
+	return target;
+}
+
+// Percent-decodes the path of a request target without its leading slash or query. Returns false
+// for paths that could reach outside the source folder.
+GEN_INTERNAL bool serve_decode_path(const char* target, uint32_t length, char* out, size_t capacity)
+{
+	if (length == 0 || target[0] != '/') {
+		return false;
+	}
+
+	size_t used = 0;
+	for (uint32_t i = 1; i < length && target[i] != '?' && target[i] != '#'; ++i) {
+		char c = target[i];
+		if (c == '%' && i + 2 < length && isxdigit((int)(unsigned char)target[i + 1]) && isxdigit((int)(unsigned char)target[i + 2])) {
+			const char hex[3] = { target[i + 1], target[i + 2], '\0' };
+			c = (char)strtol(hex, NULL, 16);
+			i += 2;
+		}
+		if (c == '\0' || c == '\\' || used + 1 >= capacity) {
+			return false;
+		}
+		out[used++] = c;
+	}
+	out[used] = '\0';
+
+	for (const char* segment = out; segment; segment = strchr(segment, '/')) {
+		segment += segment[0] == '/';
+		if (segment[0] == '.' && segment[1] == '.' && (segment[2] == '/' || segment[2] == '\0')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Percent-encodes a decoded path for a header, like the Location of a redirect. Everything but
+// unreserved characters and the slashes between segments is encoded, so spaces and control
+// characters like CR and LF can't end up in the headers as-is. out needs 3 bytes per path byte.
+GEN_INTERNAL void serve_encode_path(const char* path, char* out)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	for (; *path; ++path) {
+		const unsigned char c = (unsigned char)*path;
+		if ((c < 0x80 && isalnum(c)) || c == '-' || c == '.' || c == '_' || c == '~' || c == '/') {
+			*out++ = (char)c;
+		} else {
+			*out++ = '%';
+			*out++ = hex[c >> 4];
+			*out++ = hex[c & 0xf];
+		}
+	}
+	*out = '\0';
+}
+
+// A page rendered from markdown, or an asset sent straight from its file
+struct serve_cache_entry
+{
+	struct rjd_path path_input;
+	struct file_stamp stamp;
+	uint64_t etag;
+	char* html; // rjd_array, empty for assets
+	struct page_meta meta; // pages only, for the blog index and feed
+};
+
+// Entries are redone whenever their file's stamp changes, so edits show up on the next request
+struct serve_cache
+{
+	const char* path_source;
+	const struct page_template* template;
+	bool minify;
+	struct serve_cache_entry* entries; // rjd_array
+	struct rjd_dict lookup; // hash of path_input -> index+1 into entries
+	struct serve_cache_entry blog_index; // generated from the posts, with no file of their own
+	struct serve_cache_entry feed;
+	struct transform_scratch scratch;
+	struct rjd_mem_allocator* alloc;
+};
+
+GEN_INTERNAL void serve_cache_entry_set_html(struct serve_cache_entry* entry, const struct output_span* spans, uint32_t span_count)
+{
+	rjd_array_clear(entry->html);
+	for (uint32_t i = 0; i < span_count; ++i) {
+		const uint32_t offset = rjd_array_count(entry->html);
+		rjd_array_resize(entry->html, (uint32_t)(offset + spans[i].length));
+		memcpy(entry->html + offset, spans[i].data, spans[i].length);
+	}
+	entry->etag = rjd_hash64_data((const uint8_t*)entry->html, rjd_array_count(entry->html)).value;
+}
+
+GEN_INTERNAL bool serve_render_page(struct serve_cache* cache, const struct serve_target* target, struct serve_cache_entry* entry)
+{
+	const char* path_input = rjd_path_get(&target->path_input);
+	struct source_file source;
+	struct rjd_result result = source_file_open(&source, path_input, &cache->scratch);
+	if (!rjd_result_isok(result)) {
+		printf("Failed to read '%s': %s\n", path_input, result.error);
+		return false;
+	}
+
+	const char* path_relative = rjd_path_get(&target->path_relative);
+	const struct rjd_path root = page_root_path(path_relative);
+	struct page_fields fields;
+	page_fields_init(&fields, path_relative, rjd_path_get(&root));
+
+	struct render_state render = { .minify = cache->minify };
+	struct output_span spans[3];
+	struct gen_diagnostic diagnostic;
+	if (!render_markdown_page(source.contents, source.size, path_input, cache->template, &fields, &entry->meta, &render, &cache->scratch, spans, &diagnostic)) {
+		printf("Error (%s:%u:%u): %s\n", path_input, diagnostic.line, diagnostic.column, diagnostic.message);
+	}
+
+	serve_cache_entry_set_html(entry, spans, rjd_countof(spans));
+	source_file_close(&source);
+
+	printf("render %s -> /%s\n", path_input, path_relative);
+	fflush(stdout);
+	return true;
+}
+
+// Returns NULL if the target's file couldn't be read
+GEN_INTERNAL const struct serve_cache_entry* serve_cache_get(struct serve_cache* cache, const struct serve_target* target)
+{
+	const struct rjd_hash64 hash = rjd_hash64_str(rjd_path_get(&target->path_input));
+	uintptr_t index = (uintptr_t)rjd_dict_get(&cache->lookup, hash);
+	if (index == 0) {
+		const struct serve_cache_entry empty = { .html = rjd_array_alloc(char, 0, cache->alloc) };
+		rjd_array_push(cache->entries, empty);
+		index = rjd_array_count(cache->entries);
+		rjd_dict_insert(&cache->lookup, hash, (void*)index);
+	}
+
+	// A hash collision just shares the entry, which is redone for whichever path asks
+	struct serve_cache_entry* entry = cache->entries + index - 1;
+	if (entry->etag != 0 && !strcmp(rjd_path_get(&entry->path_input), rjd_path_get(&target->path_input)) &&
+		file_stamp_equals(entry->stamp, target->stamp)) {
+		return entry;
+	}
+
+	entry->path_input = target->path_input;
+	entry->stamp = target->stamp;
+	entry->etag = 0;
+	if (target->type == SERVE_TARGET_PAGE) {
+		if (!serve_render_page(cache, target, entry)) {
+			return NULL;
+		}
+	} else {
+		rjd_array_clear(entry->html);
+		entry->etag = rjd_hash64_data((const uint8_t*)&entry->stamp, sizeof(entry->stamp)).value;
+	}
+	return entry;
+}
+
+// The blog index and feed, generated from the dated pages the way a build generates them. Every post
+// goes through serve_cache_get(), so it's only rendered again once its stamp changes, and the index
+// is redone from the posts' meta on each request. Returns NULL unless url_path is the index or the
+// feed and the site has posts, since a build doesn't write either without them. path_relative is
+// set to where a build would write it.
+GEN_INTERNAL const struct serve_cache_entry* serve_site_index_get(struct serve_cache* cache, const char* url_path, struct rjd_path* path_relative)
+{
+	// served at /blog like any other page, as well as /blog.html
+	struct rjd_path index_url = rjd_path_init_with(SITE_BLOG_INDEX_NAME);
+	rjd_path_pop_extension(&index_url);
+	const bool is_feed = !strcmp(url_path, SITE_FEED_NAME);
+	bool is_index = !strcmp(url_path, rjd_path_get(&index_url));
+	rjd_path_append(&index_url, ".html");
+	is_index = is_index || !strcmp(url_path, rjd_path_get(&index_url));
+	if (!is_index && !is_feed) {
+		return NULL;
+	}
+
+	struct manifest_entry* posts = rjd_array_alloc(struct manifest_entry, 64, cache->alloc);
+	struct rjd_path_enumerator_state path_walker = rjd_path_enumerate_create(cache->path_source, cache->alloc, RJD_PATH_ENUMERATE_MODE_RECURSIVE);
+	for (const char* path = rjd_path_enumerate_next(&path_walker); path != NULL; path = rjd_path_enumerate_next(&path_walker)) {
+		if (!rjd_path_str_endswith(path, ".md")) {
+			continue;
+		}
+
+		struct serve_target target = { 
+			.type = SERVE_TARGET_PAGE, 
+			.path_input = rjd_path_init_with(path), 
+			.path_relative = rjd_path_init_with(path),
+		};
+		rjd_path_pop_front_path_str(&target.path_relative, cache->path_source);
+		rjd_path_pop_extension(&target.path_relative);
+		rjd_path_append(&target.path_relative, ".html");
+
+		struct page_fields fields;
+		page_fields_init(&fields, rjd_path_get(&target.path_relative), "");
+		bool is_folder = false;
+		if (fields.lengths[PAGE_FIELD_DATE] == 0 || !serve_stat(path, &target.stamp, &is_folder) || is_folder) {
+			continue;
+		}
+
+		// copied out, since the next page can move the cache's entries
+		const struct serve_cache_entry* page = serve_cache_get(cache, &target);
+		if (page && page->meta.date[0] != '\0') {
+			const struct manifest_entry post = { .path_output = target.path_relative, .meta = page->meta };
+			rjd_array_push(posts, post);
+		}
+	}
+	rjd_path_enumerate_destroy(&path_walker);
+
+	const uint32_t post_count = rjd_array_count(posts);
+	struct serve_cache_entry* entry = is_feed ? &cache->feed : &cache->blog_index;
+	if (post_count > 0) {
+		const struct manifest_entry** sorted = rjd_array_alloc(const struct manifest_entry*, post_count, cache->alloc);
+		for (uint32_t i = 0; i < post_count; ++i) {
+			rjd_array_push(sorted, posts + i);
+		}
+		qsort(sorted, post_count, sizeof(*sorted), compare_posts);
+
+		if (is_feed) {
+			*path_relative = rjd_path_init_with(SITE_FEED_NAME);
+			render_feed(sorted, &cache->scratch.page);
+			const struct output_span span = { rjd_strbuf_str(&cache->scratch.page), cache->scratch.page.length };
+			serve_cache_entry_set_html(entry, &span, 1);
+		} else {
+			*path_relative = index_url;
+			const struct rjd_path root = page_root_path(rjd_path_get(&index_url));
+			struct output_span spans[3];
+			render_blog_index(sorted, rjd_path_get(&index_url), rjd_path_get(&root), cache->template, cache->minify, &cache->scratch, spans);
+			serve_cache_entry_set_html(entry, spans, rjd_countof(spans));
+		}
+		rjd_array_free(sorted);
+	}
+
+	rjd_array_free(posts);
+	return post_count > 0 ? entry : NULL;
+}
+
+struct serve_connection
+{
+	int socket;
+	char request[GEN_SERVE_REQUEST_CAPACITY];
+	uint32_t request_length;
+	struct rjd_strbuf response; // headers, and the body when it's a page
+	uint32_t response_sent;
+	int file; // an asset body sent with sendfile(), -1 if there isn't one
+	off_t file_offset;
+	off_t file_size;
+	bool sending;
+	bool waiting_to_send; // watching for EPOLLOUT instead of EPOLLIN
+	bool keep_alive;
+	bool peer_closed;
+};
+
+GEN_INTERNAL void serve_respond(struct serve_connection* conn, const char* status, const char* content_type, uint64_t content_length, 
+	uint64_t etag, const char* location)
+{
+	rjd_strbuf_append(&conn->response, "HTTP/1.1 %s\r\n", status);
+	if (content_type) {
+		rjd_strbuf_append(&conn->response, "Content-Type: %s\r\n", content_type);
+	}
+	rjd_strbuf_append(&conn->response, "Content-Length: %" PRIu64 "\r\n", content_length);
+	if (etag) {
+		// no-cache still lets the browser keep the file, it just has to check its ETag every time
+		rjd_strbuf_append(&conn->response, "ETag: \"%016" PRIx64 "\"\r\nCache-Control: no-cache\r\n", etag);
+	}
+	if (location) {
+		rjd_strbuf_append(&conn->response, "Location: %s\r\n", location);
+	}
+	rjd_strbuf_append(&conn->response, "Connection: %s\r\n\r\n", conn->keep_alive ? "keep-alive" : "close");
+}
+
+GEN_INTERNAL void serve_respond_error(struct serve_connection* conn, const char* status, bool head)
+{
+	serve_respond(conn, status, "text/plain; charset=utf-8", strlen(status) + 1, 0, NULL);
+	if (!head) {
+		rjd_strbuf_append(&conn->response, "%s\n", status);
+	}
+}
+
+// Finds a header's value between the request line and the blank line that ends the headers
+GEN_INTERNAL bool serve_find_header(const char* headers, const char* headers_end, const char* name, const char** out_value, uint32_t* out_length)
+{
+	const size_t name_length = strlen(name);
+	for (const char* line = headers; line < headers_end; ) {
+		const char* line_end = memmem(line, (size_t)(headers_end + 2 - line), "\r\n", 2);
+		if (line_end - line > (ptrdiff_t)name_length && line[name_length] == ':' && !strncasecmp(line, name, name_length)) {
+			const char* value = line + name_length + 1;
+			while (value < line_end && (*value == ' ' || *value == '\t')) {
+				++value;
+			}
+			*out_value = value;
+			*out_length = (uint32_t)(line_end - value);
+			return true;
+		}
+		line = line_end + 2;
+	}
+	return false;
+}
+
+GEN_INTERNAL bool serve_header_has(const char* value, uint32_t length, const char* token)
+{
+	const size_t token_length = strlen(token);
+	for (uint32_t i = 0; i + token_length <= length; ++i) {
+		if (!strncasecmp(value + i, token, token_length)) {
+			return true;
+		}
+	}
+	return false;
+}
 
-	while (t->type != TOKEN_TYPE_BACKTICK) {
-		append_token_text(out, t);
-		RJD_RESULT_PROMOTE(advance_token(stream));
-		t = stream->tokens + stream->cursor;
+// Answers the first request in the buffer by filling out the response, and drops the request from
+// the buffer. Returns false if a whole request hasn't arrived yet.
+GEN_INTERNAL bool serve_connection_handle(struct serve_connection* conn, struct serve_cache* cache)
+{
+	const char* request = conn->request;
+	const char* headers_end = memmem(request, conn->request_length, "\r\n\r\n", 4);
+	if (headers_end == NULL) {
+		if (conn->request_length < sizeof(conn->request)) {
+			return false;
+		}
+		conn->keep_alive = false;
+		conn->request_length = 0;
+		serve_respond_error(conn, "431 Request Header Fields Too Large", false);
+		return true;
+	}
+	const uint32_t request_length = (uint32_t)(headers_end + 4 - request);
+
+	// the request line is <method> <target> <version>
+	const char* line_end = memmem(request, request_length, "\r\n", 2);
+	const char* method_end = memchr(request, ' ', (size_t)(line_end - request));
+	const char* target = method_end ? method_end + 1 : NULL;
+	const char* target_end = target ? memchr(target, ' ', (size_t)(line_end - target)) : NULL;
+	const char* headers = line_end + 2;
+
+	const bool head = method_end && method_end - request == 4 && !memcmp(request, "HEAD", 4);
+	const bool get = method_end && method_end - request == 3 && !memcmp(request, "GET", 3);
+	const bool http_1_1 = target_end && line_end - target_end == 9 && !memcmp(target_end + 1, "HTTP/1.1", 8);
+
+	const char* value = NULL;
+	uint32_t value_length = 0;
+	conn->keep_alive = http_1_1;
+	if (serve_find_header(headers, headers_end, "Connection", &value, &value_length)) {
+		conn->keep_alive = serve_header_has(value, value_length, "keep-alive") ||
+			(http_1_1 && !serve_header_has(value, value_length, "close"));
 	}
 
-	if (multiline) {
-		if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
-			advance_token(stream);
-			if (peek_token(stream, TOKEN_TYPE_BACKTICK)) {
-				advance_token(stream);
-				if (peek_token(stream, TOKEN_TYPE_NEWLINE)) {
-					advance_token(stream);
-				} else {
-					return result_missing_multiline_token;
-				}
-			} else {
-				return result_missing_multiline_token;
+	char url_path[RJD_PATH_BUFFER_LENGTH];
+	if (target_end == NULL) {
+		conn->keep_alive = false;
+		serve_respond_error(conn, "400 Bad Request", false);
+	} else if (!get && !head) {
+		// the request may have a body that isn't read, so the connection can't be reused
+		conn->keep_alive = false;
+		serve_respond_error(conn, "405 Method Not Allowed", false);
+	} else if (!serve_decode_path(target, (uint32_t)(target_end - target), url_path, sizeof(url_path))) {
+		serve_respond_error(conn, "404 Not Found", head);
+	} else {
+		struct serve_target resolved = { .type = SERVE_TARGET_PAGE };
+		const struct serve_cache_entry* entry = serve_site_index_get(cache, url_path, &resolved.path_relative);
+		if (entry == NULL) {
+			resolved = serve_resolve(cache->path_source, url_path);
+			if (resolved.type == SERVE_TARGET_PAGE || resolved.type == SERVE_TARGET_ASSET) {
+				entry = serve_cache_get(cache, &resolved);
 			}
 		}
 
-		rjd_strbuf_append(out, "</code></pre>\n");
-	} else {
-		rjd_strbuf_append(out, "</span>");
+		char etag[32];
+		snprintf(etag, sizeof(etag), "\"%016" PRIx64 "\"", entry ? entry->etag : 0);
+		const bool not_modified = entry && serve_find_header(headers, headers_end, "If-None-Match", &value, &value_length) &&
+			(serve_header_has(value, value_length, etag) || serve_header_has(value, value_length, "*"));
+
+		if (resolved.type == SERVE_TARGET_FOLDER) {
+			char location[RJD_PATH_BUFFER_LENGTH * 3 + 2];
+			location[0] = '/';
+			serve_encode_path(url_path, location + 1);
+			strcat(location, "/");
+			serve_respond(conn, "301 Moved Permanently", NULL, 0, 0, location);
+		} else if (entry == NULL) {
+			serve_respond_error(conn, "404 Not Found", head);
+		} else if (not_modified) {
+			serve_respond(conn, "304 Not Modified", NULL, 0, entry->etag, NULL);
+		} else if (resolved.type == SERVE_TARGET_PAGE) {
+			serve_respond(conn, "200 OK", serve_content_type(rjd_path_get(&resolved.path_relative)), rjd_array_count(entry->html), entry->etag, NULL);
+			if (!head) {
+				rjd_strbuf_appendl(&conn->response, entry->html, rjd_array_count(entry->html));
+			}
+		} else {
+			conn->file = head ? -1 : open(rjd_path_get(&resolved.path_input), O_RDONLY | O_CLOEXEC);
+			if (!head && conn->file < 0) {
+				serve_respond_error(conn, "404 Not Found", head);
+			} else {
+				conn->file_offset = 0;
+				conn->file_size = (off_t)entry->stamp.size;
+				serve_respond(conn, "200 OK", serve_content_type(url_path), entry->stamp.size, entry->etag, NULL);
+			}
+		}
 	}
 
-	return RJD_RESULT_OK();
+	memmove(conn->request, conn->request + request_length, conn->request_length - request_length);
+	conn->request_length -= request_length;
+	return true;
 }
 
-enum emphasis
+enum serve_send_result
 {
-	EMPHASIS_ITALICS,
-	EMPHASIS_BOLD,
-	EMPHASIS_ITALICS_BOLD,
-	EMPHASIS_COUNT,
+	SERVE_SEND_DONE,
+	SERVE_SEND_BLOCKED,
+	SERVE_SEND_FAILED,
 };
 
-struct rjd_result parse_emphasis(struct rjd_strbuf* out, struct token_stream* stream)
+GEN_INTERNAL enum serve_send_result serve_send_error(void)
 {
-	const struct token* t = stream->tokens + stream->cursor;
-	RJD_ASSERT(t->type == TOKEN_TYPE_UNDERSCORE);
+	return (errno == EAGAIN || errno == EWOULDBLOCK) ? SERVE_SEND_BLOCKED : SERVE_SEND_FAILED;
+}
 
-	// this underscore is in the middle of a word so it can't be emphasis
-	if (t != stream->tokens && isalpha(*(t->text - 1))) {
-		rjd_strbuf_appendl(out, t->text, t->length);
-		return RJD_RESULT_OK();
+// Sends as much of the response as the socket takes, picking up where the last call left off
+GEN_INTERNAL enum serve_send_result serve_connection_send(struct serve_connection* conn)
+{
+	while (conn->response_sent < conn->response.length) {
+		// MSG_MORE holds the headers back to go out in the same packet as the start of the file
+		const int flags = MSG_NOSIGNAL | (conn->file >= 0 ? MSG_MORE : 0);
+		const ssize_t sent = send(conn->socket, rjd_strbuf_str(&conn->response) + conn->response_sent, 
+			conn->response.length - conn->response_sent, flags);
+		if (sent < 0 && errno != EINTR) {
+			return serve_send_error();
+		}
+		conn->response_sent += sent > 0 ? (uint32_t)sent : 0;
 	}
 
-	enum emphasis emphasis = EMPHASIS_ITALICS;
-	while (rjd_result_isok(consume_token(stream, TOKEN_TYPE_UNDERSCORE))) {
-		++emphasis;
+	while (conn->file >= 0 && conn->file_offset < conn->file_size) {
+		const ssize_t sent = sendfile(conn->socket, conn->file, &conn->file_offset, (size_t)(conn->file_size - conn->file_offset));
+		if (sent == 0) {
+			// the file shrank since it was stamped, so it can't fill out its Content-Length
+			return SERVE_SEND_FAILED;
+		}
+		if (sent < 0 && errno != EINTR) {
+			return serve_send_error();
+		}
 	}
 
-	static const char* style_texts[] = 
-	{
-		"text-emphasis-1",
-		"text-emphasis-2",
-		"text-emphasis-3",
-	};
-	RJD_STATIC_ASSERT(rjd_countof(style_texts) == EMPHASIS_COUNT);
+	if (conn->file >= 0) {
+		close(conn->file);
+		conn->file = -1;
+	}
+	rjd_strbuf_clear(&conn->response);
+	conn->response_sent = 0;
+	return SERVE_SEND_DONE;
+}
 
-	rjd_strbuf_append(out, "<span class=\"");
-	rjd_strbuf_append(out, style_texts[emphasis]);
-	rjd_strbuf_append(out, "\">");
+GEN_INTERNAL void serve_connection_watch(int epoll, struct serve_connection* conn, bool writable)
+{
+	struct epoll_event event = { .events = writable ? EPOLLOUT : EPOLLIN, .data.ptr = conn };
+	epoll_ctl(epoll, EPOLL_CTL_MOD, conn->socket, &event);
+	conn->waiting_to_send = writable;
+}
 
-	t = stream->tokens + stream->cursor;
-	while (t->type != TOKEN_TYPE_UNDERSCORE) {
-		append_token_text(out, t);
-		RJD_RESULT_PROMOTE(advance_token(stream));
-		t = stream->tokens + stream->cursor;
+// Reads everything that's arrived. Returns false if the connection failed.
+GEN_INTERNAL bool serve_connection_read(struct serve_connection* conn)
+{
+	while (conn->request_length < sizeof(conn->request)) {
+		const ssize_t count = recv(conn->socket, conn->request + conn->request_length, sizeof(conn->request) - conn->request_length, 0);
+		if (count > 0) {
+			conn->request_length += (uint32_t)count;
+		} else if (count == 0) {
+			// requests that came before the end still get their responses
+			conn->peer_closed = true;
+			return true;
+		} else if (errno != EINTR) {
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
 	}
+	return true;
+}
+
+// Answers each whole request that's arrived in turn, and stops while a response waits on the
+// socket. Returns false once the connection should be closed.
+GEN_INTERNAL bool serve_connection_process(int epoll, struct serve_connection* conn, struct serve_cache* cache)
+{
+	for (;;) {
+		if (conn->sending) {
+			const enum serve_send_result sent = serve_connection_send(conn);
+			if (sent == SERVE_SEND_FAILED) {
+				return false;
+			}
+			if (sent == SERVE_SEND_BLOCKED) {
+				if (!conn->waiting_to_send) {
+					serve_connection_watch(epoll, conn, true);
+				}
+				return true;
+			}
 
-	rjd_strbuf_append(out, "</span>");
+			conn->sending = false;
+			if (conn->waiting_to_send) {
+				serve_connection_watch(epoll, conn, false);
+			}
+			if (!conn->keep_alive) {
+				return false;
+			}
+		}
 
-	enum emphasis end_emphasis = EMPHASIS_ITALICS;
-	while (peek_token(stream, TOKEN_TYPE_UNDERSCORE)) {
-		advance_token(stream);
-		++end_emphasis;
+		if (!serve_connection_handle(conn, cache)) {
+			return !conn->peer_closed;
+		}
+		conn->sending = true;
 	}
+}
 
-	if (emphasis != end_emphasis) {
-		return RJD_RESULT("Emphasis begin/end mismatch");
+GEN_INTERNAL void serve_connection_close(struct serve_connection* conn)
+{
+	// closing the socket also takes it out of the epoll set
+	close(conn->socket);
+	if (conn->file >= 0) {
+		close(conn->file);
 	}
-
-	return RJD_RESULT_OK();
+	rjd_strbuf_free(&conn->response);
+	rjd_mem_free(conn);
 }
 
-struct rjd_result transform_markdown_file(const char* path_md, const char* path_html, const char* path_root, struct rjd_mem_allocator* alloc)
+GEN_INTERNAL void serve_accept(int epoll, int listener, struct rjd_mem_allocator* alloc)
 {
-	size_t md_file_size = 0;
-	RJD_RESULT_PROMOTE(rjd_fio_size(path_md, &md_file_size));
-
-	char* md_file_contents = NULL;
-	RJD_RESULT_PROMOTE(rjd_fio_read(path_md, &md_file_contents, alloc));
+	for (;;) {
+		const int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			return;
+		}
 
-	struct token* tokens = rjd_array_alloc(struct token, 4096, alloc);
+		struct serve_connection* conn = rjd_mem_alloc(struct serve_connection, alloc);
+		conn->socket = fd;
+		conn->file = -1;
+		conn->response = rjd_strbuf_init(alloc);
 
-	const char* end = md_file_contents + md_file_size;
-	for (const char* next = md_file_contents; next < end; )
-	{
-		struct token t = {
-			.type = TOKEN_TYPE_TEXT, 
-			.text = next, 
-			.length = 1
-		};
+		struct epoll_event event = { .events = EPOLLIN, .data.ptr = conn };
+		if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+			serve_connection_close(conn);
+		}
+	}
+}
 
-		switch (*next)
-		{
-		case '\n':
-			t.type = TOKEN_TYPE_NEWLINE;
-			++next;
-			break;
-		case '#':
-			t.type = TOKEN_TYPE_HASH;
-			++next;
-			break;
-		case '*':
-			t.type = TOKEN_TYPE_ASTERISK;
-			++next;
-			break;
-		case '[':
-			t.type = TOKEN_TYPE_SQUARE_BRACKET_OPEN;
-			++next;
-			break;
-		case ']':
-			t.type = TOKEN_TYPE_SQUARE_BRACKET_CLOSE;
-			++next;
-			break;
-		case '(':
-			t.type = TOKEN_TYPE_PAREN_OPEN;
-			++next;
-			break;
-		case ')':
-			t.type = TOKEN_TYPE_PAREN_CLOSE;
-			++next;
-			break;
-		case '<':
-			t.type = TOKEN_TYPE_ANGLE_BRACKET_OPEN;
-			++next;
-			break;
-		case '>':
-			t.type = TOKEN_TYPE_ANGLE_BRACKET_CLOSE;
-			++next;
-			break;
-		case '/':
-			t.type = TOKEN_TYPE_SLASH_FORWARD;
-			++next;
-			break;
-		case '`':
-			t.type = TOKEN_TYPE_BACKTICK;
-			++next;
-			break;
-		case '_':
-			t.type = TOKEN_TYPE_UNDERSCORE;
-			++next;
-			break;
-		default:
-			while (next < end) {
-				bool end_token = false;
-				for (size_t i = 0; i < rjd_countof(TOKEN_SYMBOLS); ++i) {
-					if (*next == TOKEN_SYMBOLS[i]) {
-						end_token = true;
-						break;
-					}
-				}
-				if (end_token) {
-					break;
-				}
-				++next;
-			}
+// Serves the source folder on localhost until killed. The template must have been parsed with
+// the same minify setting.
+GEN_INTERNAL struct rjd_result serve_site(const char* path_source, uint16_t port, const struct page_template* template, bool minify, 
+	struct rjd_mem_allocator* alloc)
+{
+	// a browser closing a connection mid-response would otherwise kill gen
+	signal(SIGPIPE, SIG_IGN);
 
-			RJD_ASSERT(next > t.text);
-			t.length = (uint32_t)(next - t.text);
-			break;
-		}
+	const int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (listener < 0) {
+		return RJD_RESULT("Failed to create the server socket");
+	}
 
-		rjd_array_push(tokens, t);
+	const int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	struct sockaddr_in address = {
+		.sin_family = AF_INET,
+		.sin_port = htons(port),
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+	if (bind(listener, (const struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+		close(listener);
+		return RJD_RESULT("Failed to listen on the port");
 	}
 
-	struct rjd_strpool strings = rjd_strpool_init(alloc, 4096);
-	const char** md_lines = rjd_array_alloc(const char*, rjd_array_count(tokens), alloc);
-	struct rjd_strbuf string = rjd_strbuf_init(alloc);
+	const int epoll = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event listen_event = { .events = EPOLLIN, .data.ptr = NULL };
+	if (epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listen_event) != 0) {
+		close(listener);
+		return RJD_RESULT("Failed to initialize epoll");
+	}
 
-	struct token_stream stream =
-	{
-		.tokens = tokens,
-		.first_header_text = NULL,
-		.cursor = 0,
-		.indent = 1,
+	struct serve_cache cache = {
+		.path_source = path_source,
+		.template = template,
+		.minify = minify,
+		.entries = rjd_array_alloc(struct serve_cache_entry, 256, alloc),
+		.lookup = rjd_dict_init(alloc, 256),
+		.blog_index = { .html = rjd_array_alloc(char, 0, alloc) },
+		.feed = { .html = rjd_array_alloc(char, 0, alloc) },
+		.scratch = transform_scratch_init(alloc),
+		.alloc = alloc,
 	};
 
-	while (stream.cursor < rjd_array_count(stream.tokens))
-	{
-		struct rjd_result result = {0};
+	printf("Serving %s at http://localhost:%u/\n", path_source, (unsigned)port);
+	fflush(stdout);
 
-		string.length = 0;
-		switch (stream.tokens[stream.cursor].type)
-		{
-			case TOKEN_TYPE_NEWLINE:
-				// Markdown files with a newline at the end won't be able to advance the stream, reporting
-				// an error. Instead of propagating that error, just let the loop exit normally
-				advance_token(&stream);
-				break;
-			case TOKEN_TYPE_TEXT:
-			case TOKEN_TYPE_SQUARE_BRACKET_OPEN:
-			case TOKEN_TYPE_UNDERSCORE:
-				result = parse_paragraph(&string, &stream);
-				break;
-			case TOKEN_TYPE_HASH:
-				result = parse_header(&string, &stream);
-				break;
-			case TOKEN_TYPE_ASTERISK:
-				result = parse_list(&string, &stream);
-				break;
-			case TOKEN_TYPE_ANGLE_BRACKET_OPEN:
-				result = parse_html(&string, &stream);
-				break;
-			case TOKEN_TYPE_ANGLE_BRACKET_CLOSE:
-				result = parse_quote(&string, &stream);
-				break;
-			case TOKEN_TYPE_BACKTICK:
-				result = parse_code(&string, &stream, PARAGRAPH_POSITION_ROOT);
-				break;
-			default:
-				result = RJD_RESULT("unexpected token at top level");
-				break;
+	struct rjd_result result = RJD_RESULT_OK();
+	struct epoll_event events[GEN_SERVE_MAX_EVENTS];
+	while (rjd_result_isok(result))
+	{
+		const int ready = epoll_wait(epoll, events, GEN_SERVE_MAX_EVENTS, -1);
+		if (ready < 0) {
+			if (errno != EINTR) {
+				result = RJD_RESULT("Failed waiting for connections");
+			}
+			continue;
 		}
 
-		if (!rjd_result_isok(result)) {
-			printf("Error (%s): %s\n", path_md, result.error);
-			break;
-		}
-
-		if (string.length > 0) {
-			struct rjd_strref* ref = rjd_strpool_add(&strings, rjd_strbuf_str(&string));
-			rjd_array_push(md_lines, rjd_strref_str(ref));
-		}
-	}
-
-	const char* header_title = "";
-	if (stream.first_header_text) {
-		const struct token* t = stream.first_header_text;
-
-		rjd_strbuf_clear(&string);
-		rjd_strbuf_append(&string, "\t<title>");
-		rjd_strbuf_appendl(&string, t->text, t->length);
-		rjd_strbuf_append(&string, " | Reuben Dunnington</title>");
-		struct rjd_strref* ref = rjd_strpool_add(&strings, rjd_strbuf_str(&string));
-		header_title = rjd_strref_str(ref);
-	}
-
-	const char* header_css = "";
-	const char* header_monokai = "";
-	const char* header_highlight = "";
-	{
-		struct rjd_strref* ref = NULL;
-
-		rjd_strbuf_clear(&string);
-		rjd_strbuf_append(&string, "\t<link rel=\"stylesheet\" type=\"text/css\" href=\"");
-		rjd_strbuf_append(&string, path_root);
-		rjd_strbuf_append(&string, "styles/global.css\">");
-		ref = rjd_strpool_add(&strings, rjd_strbuf_str(&string));
-		header_css = rjd_strref_str(ref);
-
-		rjd_strbuf_clear(&string);
-		rjd_strbuf_append(&string, "\t<link rel=\"stylesheet\" type=\"text/css\" href=\"");
-		rjd_strbuf_append(&string, path_root);
-		rjd_strbuf_append(&string, "script/highlight/monokai.css\">");
-		ref = rjd_strpool_add(&strings, rjd_strbuf_str(&string));
-		header_monokai = rjd_strref_str(ref);
-
-		rjd_strbuf_clear(&string);
-		rjd_strbuf_append(&string, "\t<script src=\"");
-		rjd_strbuf_append(&string, path_root);
-		rjd_strbuf_append(&string, "script/highlight/highlight.pack.js\"></script>");
-		ref = rjd_strpool_add(&strings, rjd_strbuf_str(&string));
-		header_highlight = rjd_strref_str(ref);
-	}
-
-	rjd_strbuf_free(&string);
-
-	const char* header_lines[] = 
-	{
-		"<!DOCTYPE html>",
-		"<html>",
-		"<head>",
-		header_title,
-		"\t<meta charset=\"UTF-8\">",
-		"\t<meta name=\"description\" content=\"Personal website with a blog and resume.\">",
-		"\t<meta name=\"keywords\" content=\"programming, blog\">",
-		"\t<meta name=\"author\" content=\"Reuben Dunnington\">",
-		"\t<meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">",
-		header_css,
-		header_monokai,
-		header_highlight,
-		"\t<script>hljs.initHighlightingOnLoad();</script>",
-		"</head>",
-		"<body>",
-		"\t<nav>",
-		"\t\t<a href=\"/\">Home</a>",
-		"\t\t<a href=\"/resume\">Resume</a>",
-		"\t\t<a href=\"/projects\">Projects</a>",
-		"\t\t<a href=\"/blog\">Blog</a>",
-		"\t</nav>",
-	};
-
-	const char* footer_lines[] = 
-	{
-		"</body>",
-		"</html>",
-	};
+		for (int i = 0; i < ready; ++i) {
+			struct serve_connection* conn = events[i].data.ptr;
+			if (conn == NULL) {
+				serve_accept(epoll, listener, alloc);
+				continue;
+			}
 
-	// ensure the path exists
-	{
-		struct rjd_path output_folder = rjd_path_init_with(path_html);
-		rjd_path_pop(&output_folder);
-		rjd_fio_mkdir(rjd_path_get(&output_folder));
+			bool open = !(events[i].events & (EPOLLERR | EPOLLHUP));
+			if (open && (events[i].events & EPOLLIN)) {
+				open = serve_connection_read(conn);
+			}
+			if (open) {
+				open = serve_connection_process(epoll, conn, &cache);
+			}
+			if (!open) {
+				serve_connection_close(conn);
+			}
+		}
 	}
 
-	FILE* file_html = fopen(path_html, "wt");
-	if (!file_html) {
-		return RJD_RESULT("Failed to open output file path for write");
+	close(epoll);
+	close(listener);
+	for (uint32_t i = 0; i < rjd_array_count(cache.entries); ++i) {
+		rjd_array_free(cache.entries[i].html);
 	}
+	rjd_array_free(cache.entries);
+	rjd_array_free(cache.blog_index.html);
+	rjd_array_free(cache.feed.html);
+	rjd_dict_free(&cache.lookup);
+	transform_scratch_free(&cache.scratch);
+	return result;
+}
 
-	for (size_t i = 0; i < rjd_countof(header_lines); ++i)
-	{
-		fprintf(file_html, "%s\n", header_lines[i]);
-	}
+#endif // defined(__linux__)
 
-	for (size_t i = 0; i < rjd_array_count(md_lines); ++i)
-	{
-		fprintf(file_html, "%s", md_lines[i]);
-	}
+// One JSON object per line so runs can be collected and compared. Stage times are summed across
+// workers, so with more than one worker they add up to more than the wall time.
+// Tokenizing, parsing and rendering, which is where pathological markdown would show up
+GEN_INTERNAL double markdown_mbps(const struct transform_timings* timings)
+{
+	const double seconds = timings->tokenize + timings->parse + timings->render;
+	return seconds > 0.0 ? timings->bytes_in / (1024.0 * 1024.0) / seconds : 0.0;
+}
 
-	for (size_t i = 0; i < rjd_countof(footer_lines); ++i)
-	{
-		fprintf(file_html, "%s\n", footer_lines[i]);
-	}
+GEN_INTERNAL void print_bench_results(const struct transform_timings* timings, uint32_t file_count, uint32_t worker_count, double wall)
+{
+	const double mb_in = timings->bytes_in / (1024.0 * 1024.0);
+	const double mb_out = timings->bytes_out / (1024.0 * 1024.0);
+	#define GEN_PER_SECOND(amount, seconds) ((seconds) > 0.0 ? (amount) / (seconds) : 0.0)
+
+	printf("{\"workers\":%u,\"files\":%u,\"pages\":%" PRIu64 ",\"bytes_in\":%" PRIu64 ",\"bytes_out\":%" PRIu64 ",", 
+		worker_count, file_count, timings->pages, timings->bytes_in, timings->bytes_out);
+	printf("\"rewritten_files\":%" PRIu64 ",\"unchanged_files\":%" PRIu64 ",", timings->rewritten_files, timings->unchanged_files);
+	printf("\"wall_ms\":%.3f,\"read_ms\":%.3f,\"tokenize_ms\":%.3f,\"parse_ms\":%.3f,\"render_ms\":%.3f,\"emit_ms\":%.3f,\"write_ms\":%.3f,\"compress_ms\":%.3f,",
+		wall * 1000.0, timings->read * 1000.0, timings->tokenize * 1000.0, timings->parse * 1000.0, timings->render * 1000.0, 
+		timings->emit * 1000.0, timings->write * 1000.0, timings->compress * 1000.0);
+	printf("\"read_mbps\":%.1f,\"tokenize_mbps\":%.1f,\"parse_mbps\":%.1f,\"render_mbps\":%.1f,\"emit_pages_per_s\":%.1f,\"write_mbps\":%.1f,",
+		GEN_PER_SECOND(mb_in, timings->read), GEN_PER_SECOND(mb_in, timings->tokenize), GEN_PER_SECOND(mb_in, timings->parse),
+		GEN_PER_SECOND(mb_in, timings->render), GEN_PER_SECOND((double)timings->pages, timings->emit), GEN_PER_SECOND(mb_out, timings->write));
+	printf("\"markdown_mbps\":%.1f,\"markdown_ms_per_mb\":%.3f,", markdown_mbps(timings), 
+		GEN_PER_SECOND((timings->tokenize + timings->parse + timings->render) * 1000.0, mb_in));
+	printf("\"total_mbps\":%.1f,\"pages_per_s\":%.1f}\n", GEN_PER_SECOND(mb_in, wall), GEN_PER_SECOND((double)timings->pages, wall));
+
+	#undef GEN_PER_SECOND
+}
 
-	fclose(file_html);
-	rjd_array_free(tokens);
-	rjd_array_free(md_lines);
-	rjd_strpool_free(&strings);
+GEN_INTERNAL void print_usage(const char* exe)
+{
+	printf("Usage: %s [-j <worker count>] [--force] [--link-assets] [--arena-stats] [--template <file>] [--bench [--bench-min-mbps <n>]] [--trace <file>] [--watch] [--gzip <level>] [--zstd <level>] [--minify] [--fingerprint] [--critical-css] <input folder> <output folder>\n", exe);
+	printf("       %s --stream [--template <file>] [--minify] < input.md > output.html\n", exe);
+	printf("       %s --serve [--template <file>] [--minify] <input folder> <port>\n", exe);
+	printf("\t-j <worker count>  Number of threads to build with (default 1)\n");
+	printf("\t--force            Ignore the manifest from the previous build and rebuild everything\n");
+	printf("\t--link-assets      Hardlink non-markdown files into the output instead of copying them\n");
+	printf("\t--arena-stats      Print how much of the per-page arena each page used\n");
+	printf("\t--template <file>  Page template to render markdown into (default is the built-in copy of templates/page.html)\n");
+	printf("\t--bench            Rebuild everything, then print stage timings as a line of JSON\n");
+	printf("\t--bench-min-mbps <n>  With --bench, fail if markdown was tokenized, parsed and rendered slower than n MB/s\n");
+	printf("\t--trace <file>     Write a Chrome trace (chrome://tracing, Perfetto) of every build phase\n");
+	printf("\t--watch            After building, keep running and rebuild files as they change (Linux only)\n");
+	printf("\t--stream           Render markdown from stdin to stdout a block at a time, without a whole-file buffer\n");
+	printf("\t--serve            Preview the site on localhost, rendering pages from memory as they're requested (Linux only)\n");
+	printf("\t--gzip <level>     Also write a .gz next to each page and text asset, compressed at level 1-9\n");
+	printf("\t--zstd <level>     Also write a .zst next to each page and text asset, compressed at level 1-19 (builds with GEN_ZSTD=1 only)\n");
+	printf("\t--minify           Leave indentation and optional whitespace out of pages, and minify stylesheets as they're copied\n");
+	printf("\t--fingerprint      Also write stylesheets, scripts, images and fonts under content-hashed names, and point the template and html blocks at them\n");
+	printf("\t--critical-css     Inline the rules of the template's stylesheets each page uses into its head, and load the stylesheets without blocking\n");
+}
 
-	return RJD_RESULT_OK();
+GEN_INTERNAL bool load_page_template(struct page_template* template, const char* path_template, bool minify, bool async_styles, 
+	const struct asset_map* assets, struct rjd_mem_allocator* alloc)
+{
+	struct rjd_result result = page_template_load(template, path_template, minify, async_styles, assets, alloc);
+	if (!rjd_result_isok(result)) {
+		printf("Failed to load template '%s': %s\n", path_template ? path_template : "(default)", result.error);
+	}
+	return rjd_result_isok(result);
 }
 
+#if !GEN_LIBRARY
 int main(int argc, const char** argv)
 {
-	if (argc < 3) {
-		printf("Usage: %s <input folder> <output folder>\n", argv[0]);
+	const char* path_source = NULL;
+	const char* path_destination = NULL;
+	uint32_t worker_count = 1;
+	bool force_rebuild = false;
+	bool hardlink_assets = false;
+	bool print_arena_stats = false;
+	bool watch = false;
+	bool bench = false;
+	double bench_min_mbps = 0.0;
+	bool stream = false;
+	bool serve = false;
+	bool minify = false;
+	bool fingerprint = false;
+	bool critical_css = false;
+	const char* path_trace = NULL;
+	const char* path_template = NULL;
+	struct compress_settings compress = {0};
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			int count = atoi(argv[++i]);
+			worker_count = count > 0 ? (uint32_t)count : 1;
+		} else if (!strcmp(argv[i], "--force")) {
+			force_rebuild = true;
+		} else if (!strcmp(argv[i], "--link-assets")) {
+			hardlink_assets = true;
+		} else if (!strcmp(argv[i], "--arena-stats")) {
+			print_arena_stats = true;
+		} else if (!strcmp(argv[i], "--bench")) {
+			bench = true;
+			force_rebuild = true;
+		} else if (!strcmp(argv[i], "--bench-min-mbps") && i + 1 < argc) {
+			bench_min_mbps = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--watch")) {
+			watch = true;
+		} else if (!strcmp(argv[i], "--stream")) {
+			stream = true;
+		} else if (!strcmp(argv[i], "--serve")) {
+			serve = true;
+		} else if (!strcmp(argv[i], "--minify")) {
+			minify = true;
+		} else if (!strcmp(argv[i], "--fingerprint")) {
+			fingerprint = true;
+		} else if (!strcmp(argv[i], "--critical-css")) {
+			critical_css = true;
+		} else if (!strcmp(argv[i], "--template") && i + 1 < argc) {
+			path_template = argv[++i];
+		} else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+			path_trace = argv[++i];
+		} else if (!strcmp(argv[i], "--gzip") && i + 1 < argc) {
+			compress.levels[COMPRESS_FORMAT_GZIP] = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--zstd") && i + 1 < argc) {
+			compress.levels[COMPRESS_FORMAT_ZSTD] = atoi(argv[++i]);
+		} else if (path_source == NULL) {
+			path_source = argv[i];
+		} else if (path_destination == NULL) {
+			path_destination = argv[i];
+		} else {
+			print_usage(argv[0]);
+			return 0;
+		}
+	}
+
+	if (!stream && (path_source == NULL || path_destination == NULL)) {
+		print_usage(argv[0]);
 		return 0;
 	}
 
+	for (uint32_t format = 0; format < COMPRESS_FORMAT_COUNT; ++format) {
+		if (compress.levels[format] > 0 && !COMPRESS_FORMAT_AVAILABLE[format]) {
+			printf("--%s isn't available in this build of gen\n", COMPRESS_FORMAT_NAMES[format]);
+			return 1;
+		}
+		compress.levels[format] = rjd_math_max_i32(0, rjd_math_min_i32(compress.levels[format], COMPRESS_FORMAT_MAX_LEVELS[format]));
+	}
+
+	text_scan_init(TEXT_SCAN_ISA_DETECT);
+
 	struct rjd_mem_allocator alloc = rjd_mem_allocator_init_default();
 
-	const char* path_source = argv[1];
-	const char* path_destination = argv[2];
+	struct page_template page_template = {0};
+
+	// stdout is the page, so errors go to stderr
+	if (stream) {
+		if (!load_page_template(&page_template, path_template, minify, false, NULL, &alloc)) {
+			return 1;
+		}
+
+		struct transform_scratch scratch = transform_scratch_init(&alloc);
+		struct rjd_strbuf log = rjd_strbuf_init(&alloc);
+		struct rjd_result stream_result = transform_markdown_stream(stdin, "stdin", stdout, &page_template, minify, &scratch, &log);
+		fputs(rjd_strbuf_str(&log), stderr);
+		if (!rjd_result_isok(stream_result)) {
+			fprintf(stderr, "%s\n", stream_result.error);
+		}
+		rjd_strbuf_free(&log);
+		transform_scratch_free(&scratch);
+		page_template_free(&page_template);
+		return rjd_result_isok(stream_result) ? 0 : 1;
+	}
+
+	// the second folder is the port instead, since nothing is written
+	if (serve) {
+	#if defined(__linux__)
+		const int port = atoi(path_destination);
+		if (port <= 0 || port > UINT16_MAX) {
+			printf("--serve needs a port from 1 to %u, not '%s'\n", UINT16_MAX, path_destination);
+			return 1;
+		}
+		if (!load_page_template(&page_template, path_template, minify, false, NULL, &alloc)) {
+			return 1;
+		}
+
+		struct rjd_result serve_result = serve_site(path_source, (uint16_t)port, &page_template, minify, &alloc);
+		printf("%s\n", serve_result.error);
+		page_template_free(&page_template);
+		return 1;
+	#else
+		printf("--serve is only supported on Linux\n");
+		return 1;
+	#endif
+	}
+
+	struct rjd_timer timer = rjd_timer_init();
+
+	struct trace trace = {0};
+	if (path_trace) {
+		trace_init(&trace, &alloc);
+	}
+	struct trace_buffer* trace_main = trace_thread_begin(path_trace ? &trace : NULL, "main");
 
-	struct rjd_strbuf system_command = rjd_strbuf_init(&alloc);
+	struct build_job* jobs = rjd_array_alloc(struct build_job, 256, &alloc);
 
+	double trace_begin = trace_now(trace_main);
 	struct rjd_path_enumerator_state path_walker = rjd_path_enumerate_create(path_source, &alloc, RJD_PATH_ENUMERATE_MODE_RECURSIVE);
+	trace_begin = trace_scope(trace_main, "enumerate paths", NULL, trace_begin);
+
 	for(const char* path_input = rjd_path_enumerate_next(&path_walker);
 		path_input != NULL;
 		path_input = rjd_path_enumerate_next(&path_walker)) 
 	{
+		trace_begin = trace_scope(trace_main, "enumerate next", NULL, trace_begin);
+
 		enum rjd_fio_attributes attribs = 0;
-		if (!rjd_result_isok(rjd_fio_attributes_get(path_input, &attribs)) || (attribs & RJD_FIO_ATTRIBUTES_DIRECTORY)) {
+		const bool is_file = rjd_result_isok(rjd_fio_attributes_get(path_input, &attribs)) && !(attribs & RJD_FIO_ATTRIBUTES_DIRECTORY);
+		trace_begin = trace_scope(trace_main, "get attributes", NULL, trace_begin);
+		if (!is_file) {
 			continue;
 		}
 
@@ -865,48 +7288,160 @@ int main(int argc, const char** argv)
 			continue;
 		}
 
-		struct rjd_path path_output = rjd_path_init_with(path_input);
-		rjd_path_pop_front_path_str(&path_output, path_source);
-		rjd_path_join_front(&path_output, path_destination);
+		struct build_job job = build_job_init(path_input, path_source, path_destination);
+		rjd_array_push(jobs, job);
+	}
 
-		const bool is_markdown = rjd_path_str_endswith(path_input, ".md");
-		if (is_markdown) {
-			rjd_path_pop_extension(&path_output);
-			rjd_path_append(&path_output, ".html");
+	rjd_path_enumerate_destroy(&path_walker);
 
-			struct rjd_path to_root = rjd_path_init();
-			struct rjd_path output_copy = path_output;
-			rjd_path_pop(&output_copy);
-			rjd_path_pop(&output_copy);
-			while (output_copy.length != 0) {
-				rjd_path_pop(&output_copy);
-				rjd_path_join_str(&to_root, "..");
-			}
+	struct rjd_path path_manifest = rjd_path_init_with(path_destination);
+	rjd_path_join_str(&path_manifest, GEN_MANIFEST_FILENAME);
+
+	trace_begin = trace_now(trace_main);
+	struct manifest previous_manifest = manifest_init(&alloc);
+	const bool has_previous_manifest = !force_rebuild && 
+		rjd_result_isok(manifest_read(&previous_manifest, rjd_path_get(&path_manifest), &alloc));
+	trace_begin = trace_scope(trace_main, "read manifest", NULL, trace_begin);
+
+	struct build_context context = {
+		.page_template = &page_template,
+		.previous_manifest = has_previous_manifest ? &previous_manifest : NULL,
+		.force_rebuild = force_rebuild,
+		.hardlink_assets = hardlink_assets,
+		.print_arena_stats = print_arena_stats,
+		.quiet = bench,
+		.minify = minify,
+		.fingerprint = fingerprint,
+		.compress = compress,
+		.trace = path_trace ? &trace : NULL,
+		.trace_main = trace_main,
+	};
 
-			if (to_root.length > 0) {
-				rjd_path_append(&to_root, "/");
-			}
+	// The template's html is filled in from the asset map, so it's loaded once the map is built
+	struct asset_map assets = {
+		.infos = rjd_array_alloc(struct asset_info, 64, &alloc),
+		.lookup = rjd_dict_init(&alloc, 64),
+	};
+	{
+		struct transform_scratch scratch = transform_scratch_init(&alloc);
+		asset_map_build(&assets, jobs, &context, &scratch);
+		transform_scratch_free(&scratch);
+		context.assets = &assets;
+		trace_begin = trace_scope(trace_main, "asset map", NULL, trace_begin);
+	}
 
-			const char* path_output_str = rjd_path_get(&path_output);
-			printf("transform %s -> %s\n", path_input, path_output_str);
+	if (!load_page_template(&page_template, path_template, minify, critical_css, context.assets, &alloc)) {
+		return 1;
+	}
 
-			struct rjd_result r = transform_markdown_file(path_input, path_output_str, rjd_path_get(&to_root), &alloc);
-			if (rjd_result_isok(r) == false) {
-				printf("Markdown error in file '%s': %s\n", path_input, r.error);
-			}
-		} else {
-			struct rjd_path folder = rjd_path_init_with(rjd_path_get(&path_output));
-			rjd_path_pop(&folder);
-			rjd_fio_mkdir(rjd_path_get(&folder));
-			rjd_strbuf_append(&system_command, "cp -R %s %s", path_input, rjd_path_get(&path_output));
+	struct critical_css critical = {0};
+	if (critical_css) {
+		struct rjd_result result = critical_css_load(&critical, &page_template, path_source, &alloc);
+		if (!rjd_result_isok(result)) {
+			printf("Failed to load the template's stylesheets for --critical-css: %s\n", result.error);
+			return 1;
+		}
+		trace_begin = trace_scope(trace_main, "critical css", NULL, trace_begin);
+	}
+
+	struct build_stats stats = run_build_jobs(jobs, &context, worker_count, &alloc);
+	trace_begin = trace_scope(trace_main, "build", NULL, trace_begin);
 
-			printf("%s\n", rjd_strbuf_str(&system_command));
-			system(rjd_strbuf_str(&system_command));
-			rjd_strbuf_clear(&system_command);
+	// Failed jobs are left out of the manifest so they're retried next run
+	struct manifest manifest = manifest_init(&alloc);
+	uint32_t up_to_date_count = 0;
+	for (uint32_t i = 0; i < rjd_array_count(jobs); ++i) {
+		if (jobs[i].built) {
+			manifest_add(&manifest, &jobs[i].manifest_entry);
+		}
+		if (jobs[i].up_to_date) {
+			++up_to_date_count;
 		}
 	}
 
-	rjd_path_enumerate_destroy(&path_walker);
+	rjd_fio_mkdir(path_destination);
+	struct rjd_result manifest_result = manifest_write(&manifest, rjd_path_get(&path_manifest), &alloc);
+	if (!rjd_result_isok(manifest_result)) {
+		printf("Failed to write manifest '%s': %s\n", rjd_path_get(&path_manifest), manifest_result.error);
+	}
+	trace_begin = trace_scope(trace_main, "write manifest", NULL, trace_begin);
+
+	uint32_t post_count = 0;
+	struct rjd_result index_result = write_site_index(&manifest, path_source, path_destination, &page_template, context.minify, 
+		&context.compress, &post_count, &stats.timings, &alloc);
+	if (!rjd_result_isok(index_result)) {
+		printf("Failed to write the blog index: %s\n", index_result.error);
+	} else if (post_count > 0) {
+		printf("Indexed %u posts into the blog index and %s\n", post_count, SITE_FEED_NAME);
+	}
+	trace_scope(trace_main, "site index", NULL, trace_begin);
+
+	// Written before watching since watch mode never returns, and later rebuilds aren't traced
+	if (path_trace) {
+		struct rjd_result trace_result = trace_write(&trace, path_trace);
+		if (!rjd_result_isok(trace_result)) {
+			printf("Failed to write trace '%s': %s\n", path_trace, trace_result.error);
+		}
+		trace_free(&trace);
+		context.trace = NULL;
+		context.trace_main = NULL;
+	}
+
+	// before the build time, which make scaling reads off the last line
+	if (stats.timings.rewritten_files + stats.timings.unchanged_files > 0) {
+		printf("Rewrote %" PRIu64 " output file(s) and left %" PRIu64 " unchanged\n", stats.timings.rewritten_files, stats.timings.unchanged_files);
+	}
+	const double build_time = rjd_timer_elapsed(&timer);
+	printf("Built %u files (%u up to date) in %.1f ms with %u worker(s)\n", 
+		rjd_array_count(jobs), up_to_date_count, build_time * 1000.0, worker_count);
+	if (stats.timings.minified_bytes > 0) {
+		printf("Minifying saved %.1f KB\n", stats.timings.minified_bytes / 1024.0);
+	}
+	if (stats.timings.critical_css_bytes > 0) {
+		printf("Inlined %.1f KB of critical css, %.0f%% of the stylesheets per page\n", stats.timings.critical_css_bytes / 1024.0, 
+			stats.timings.critical_css_bytes * 100.0 / ((double)stats.timings.pages * critical.text.length));
+	}
+	if (print_arena_stats) {
+		printf("Largest page arena high water: %.1f KB\n", stats.arena_high_water / 1024.0);
+		printf("Largest document arena high water: %.1f KB\n", stats.doc_arena_high_water / 1024.0);
+	}
+	// a bench that's too slow fails, so the worst case corpus can gate on it
+	int exit_code = 0;
+	if (bench) {
+		print_bench_results(&stats.timings, rjd_array_count(jobs), worker_count, build_time);
+		if (markdown_mbps(&stats.timings) < bench_min_mbps) {
+			printf("Markdown throughput of %.1f MB/s is below the minimum of %.1f MB/s\n", markdown_mbps(&stats.timings), bench_min_mbps);
+			exit_code = 1;
+		}
+	}
+
+	if (watch) {
+	#if defined(__linux__)
+		fflush(stdout);
+		const struct watch_paths watch_paths = {
+			.source = path_source,
+			.destination = path_destination,
+			.manifest = rjd_path_get(&path_manifest),
+		};
+		struct rjd_result watch_result = watch_site(&watch_paths, &manifest, &context, worker_count, &alloc);
+		if (!rjd_result_isok(watch_result)) {
+			printf("%s\n", watch_result.error);
+		}
+	#else
+		printf("--watch is only supported on Linux\n");
+	#endif
+	}
+
+	manifest_free(&manifest);
+	manifest_free(&previous_manifest);
+	page_template_free(&page_template);
+	if (critical_css) {
+		critical_css_free(&critical);
+	}
+	rjd_array_free(assets.infos);
+	rjd_dict_free(&assets.lookup);
+	rjd_array_free(jobs);
 
-	return 0;
+	return exit_code;
 }
+#endif
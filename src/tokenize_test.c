@@ -0,0 +1,250 @@
+// Checks tokenize() and append_html_escaped() with every scanner text_scan_init() can pick on this
+// CPU against the byte-at-a-time loops they replaced, on random buffers and on the markdown files in
+// the folders given. make tokentest builds and runs it, and it exits with 1 at the first difference.
+//	tokenize_test [folder]...
+// It includes main.c to get at its internals, so it's built on its own, without libgen.a.
+
+#define GEN_LIBRARY 1
+#include "main.c"
+
+#define TOKENIZE_TEST_SEED 1
+#define TOKENIZE_TEST_RANDOM_BUFFERS 3000
+#define TOKENIZE_TEST_MAX_RANDOM_LENGTH 4096
+
+// The symbols the tokenizer used before TOKEN_CLASSES. The 0 ended a text run, and then tripped the
+// assert below, so the buffers here never contain a NUL.
+static const char OLD_TOKEN_SYMBOLS[] =
+{
+	0, '\n', '#', '*', '[', ']', '(', ')', '<', '>', '/', '`', '_',
+};
+RJD_STATIC_ASSERT(rjd_countof(OLD_TOKEN_SYMBOLS) == TOKEN_TYPE_COUNT);
+
+// The tokenizer loop as it was inlined in transform_markdown_file
+static struct token* tokenize_old(const char* text, size_t length, struct rjd_mem_allocator* alloc)
+{
+	struct token* tokens = rjd_array_alloc(struct token, 4096, alloc);
+
+	const char* end = text + length;
+	for (const char* next = text; next < end; )
+	{
+		struct token t = {
+			.type = TOKEN_TYPE_TEXT,
+			.text = next,
+			.length = 1
+		};
+
+		switch (*next)
+		{
+		case '\n': t.type = TOKEN_TYPE_NEWLINE; ++next; break;
+		case '#': t.type = TOKEN_TYPE_HASH; ++next; break;
+		case '*': t.type = TOKEN_TYPE_ASTERISK; ++next; break;
+		case '[': t.type = TOKEN_TYPE_SQUARE_BRACKET_OPEN; ++next; break;
+		case ']': t.type = TOKEN_TYPE_SQUARE_BRACKET_CLOSE; ++next; break;
+		case '(': t.type = TOKEN_TYPE_PAREN_OPEN; ++next; break;
+		case ')': t.type = TOKEN_TYPE_PAREN_CLOSE; ++next; break;
+		case '<': t.type = TOKEN_TYPE_ANGLE_BRACKET_OPEN; ++next; break;
+		case '>': t.type = TOKEN_TYPE_ANGLE_BRACKET_CLOSE; ++next; break;
+		case '/': t.type = TOKEN_TYPE_SLASH_FORWARD; ++next; break;
+		case '`': t.type = TOKEN_TYPE_BACKTICK; ++next; break;
+		case '_': t.type = TOKEN_TYPE_UNDERSCORE; ++next; break;
+		default:
+			while (next < end) {
+				bool end_token = false;
+				for (size_t i = 0; i < rjd_countof(OLD_TOKEN_SYMBOLS); ++i) {
+					if (*next == OLD_TOKEN_SYMBOLS[i]) {
+						end_token = true;
+						break;
+					}
+				}
+				if (end_token) {
+					break;
+				}
+				++next;
+			}
+
+			RJD_ASSERT(next > t.text);
+			t.length = (uint32_t)(next - t.text);
+			break;
+		}
+
+		rjd_array_push(tokens, t);
+	}
+
+	return tokens;
+}
+
+// Escaping one byte at a time, as append_html_escaped() did before it scanned for special characters
+static void append_html_escaped_old(struct rjd_strbuf* out, const char* text, size_t length)
+{
+	for (size_t i = 0; i < length; ++i) {
+		const char* escaped = HTML_ESCAPES[(uint8_t)text[i]];
+		if (escaped) {
+			rjd_strbuf_appendl(out, escaped, (uint32_t)strlen(escaped));
+		} else {
+			rjd_strbuf_appendl(out, text + i, 1);
+		}
+	}
+}
+
+static const char* ISA_NAMES[] =
+{
+	"detect",
+	"scalar",
+	"sse2",
+	"avx2",
+	"neon",
+};
+RJD_STATIC_ASSERT(rjd_countof(ISA_NAMES) == TEXT_SCAN_ISA_NEON + 1);
+
+static bool compare_scanners(const char* text, size_t length, const char* label, enum text_scan_isa isa, struct rjd_mem_allocator* alloc)
+{
+	bool ok = true;
+
+	struct token* expected = tokenize_old(text, length, alloc);
+	struct token* tokens = tokenize(text, length, tokenize_count(text, length), alloc);
+	const uint32_t count = rjd_array_count(tokens);
+	if (count != rjd_array_count(expected)) {
+		printf("%s (%s): %u tokens, expected %u\n", label, ISA_NAMES[isa], count, rjd_array_count(expected));
+		ok = false;
+	}
+	for (uint32_t i = 0; ok && i < count; ++i) {
+		if (tokens[i].type != expected[i].type || tokens[i].text != expected[i].text || tokens[i].length != expected[i].length) {
+			printf("%s (%s): token %u at byte %zu is type %d length %u, expected type %d length %u\n", label, ISA_NAMES[isa], i,
+				(size_t)(expected[i].text - text), tokens[i].type, tokens[i].length, expected[i].type, expected[i].length);
+			ok = false;
+		}
+	}
+	if (ok && (tokens[count].type != TOKEN_TYPE_TEXT || tokens[count].text != NULL || tokens[count].length != 0)) {
+		printf("%s (%s): the token after the last one isn't empty\n", label, ISA_NAMES[isa]);
+		ok = false;
+	}
+	rjd_array_free(tokens);
+	rjd_array_free(expected);
+
+	struct rjd_strbuf escaped_expected = rjd_strbuf_init(alloc);
+	struct rjd_strbuf escaped = rjd_strbuf_init(alloc);
+	append_html_escaped_old(&escaped_expected, text, length);
+	append_html_escaped(&escaped, text, length);
+	if (ok && (escaped.length != escaped_expected.length || memcmp(rjd_strbuf_str(&escaped), rjd_strbuf_str(&escaped_expected), escaped.length) != 0)) {
+		printf("%s (%s): escaped html differs\n", label, ISA_NAMES[isa]);
+		ok = false;
+	}
+	rjd_strbuf_free(&escaped);
+	rjd_strbuf_free(&escaped_expected);
+
+	return ok;
+}
+
+// xorshift64, so every run checks the same buffers
+static uint64_t random_next(uint64_t* state)
+{
+	uint64_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+// Buffers from all symbols to almost all text, with html specials and bytes over 0x7f mixed in since
+// the SIMD scanners split bytes into nibbles. Each one starts at a random offset so the SIMD loads
+// aren't aligned, and the lengths cover the scalar tails after the last full 16 or 32 byte chunk.
+static bool check_random_buffers(enum text_scan_isa isa, struct rjd_mem_allocator* alloc)
+{
+	static const char SPECIALS[] = "\n#*[]()<>/`_&\"'";
+
+	char* buffer = rjd_mem_alloc_array(char, TOKENIZE_TEST_MAX_RANDOM_LENGTH + 64, alloc);
+	uint64_t state = TOKENIZE_TEST_SEED * 0x9E3779B97F4A7C15ull;
+
+	bool ok = true;
+	for (uint32_t i = 0; ok && i < TOKENIZE_TEST_RANDOM_BUFFERS; ++i) {
+		const uint32_t offset = (uint32_t)(random_next(&state) % 64);
+		const size_t length = (size_t)(random_next(&state) % (i % 10 == 0 ? TOKENIZE_TEST_MAX_RANDOM_LENGTH : 80));
+		const uint32_t special_odds = 1 + (uint32_t)(random_next(&state) % 256);
+
+		char* text = buffer + offset;
+		for (size_t c = 0; c < length; ++c) {
+			const uint64_t r = random_next(&state);
+			if (r % special_odds == 0) {
+				text[c] = SPECIALS[(r >> 16) % (sizeof(SPECIALS) - 1)];
+			} else {
+				text[c] = (char)(1 + (r >> 16) % 255);
+			}
+		}
+
+		char label[64];
+		snprintf(label, sizeof(label), "random buffer %u", i);
+		ok = compare_scanners(text, length, label, isa, alloc);
+	}
+
+	rjd_mem_free(buffer);
+	return ok;
+}
+
+static bool check_folder(const char* path_folder, enum text_scan_isa isa, uint32_t* file_count, struct rjd_mem_allocator* alloc)
+{
+	bool ok = true;
+
+	struct rjd_path_enumerator_state path_walker = rjd_path_enumerate_create(path_folder, alloc, RJD_PATH_ENUMERATE_MODE_RECURSIVE);
+	for (const char* path = rjd_path_enumerate_next(&path_walker); ok && path != NULL; path = rjd_path_enumerate_next(&path_walker)) {
+		if (!rjd_path_str_endswith(path, ".md")) {
+			continue;
+		}
+
+		char* contents = NULL;
+		struct rjd_result result = rjd_fio_read(path, &contents, alloc);
+		if (!rjd_result_isok(result)) {
+			printf("Failed to read %s: %s\n", path, result.error);
+			ok = false;
+			break;
+		}
+
+		const size_t length = rjd_array_count(contents);
+		if (memchr(contents, 0, length) == NULL) {
+			ok = compare_scanners(contents, length, path, isa, alloc);
+			++*file_count;
+		}
+		rjd_array_free(contents);
+	}
+	rjd_path_enumerate_destroy(&path_walker);
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	struct rjd_mem_allocator alloc = rjd_mem_allocator_init_default();
+
+	enum text_scan_isa isas[4];
+	uint32_t isa_count = 0;
+	isas[isa_count++] = TEXT_SCAN_ISA_SCALAR;
+#if GEN_TOKENIZER_X64
+	isas[isa_count++] = TEXT_SCAN_ISA_SSE2;
+	if (cpu_supports_avx2()) {
+		isas[isa_count++] = TEXT_SCAN_ISA_AVX2;
+	} else {
+		printf("Skipping avx2, which this CPU doesn't support\n");
+	}
+#elif GEN_TOKENIZER_NEON
+	isas[isa_count++] = TEXT_SCAN_ISA_NEON;
+#endif
+
+	for (uint32_t i = 0; i < isa_count; ++i) {
+		text_scan_init(isas[i]);
+
+		if (!check_random_buffers(isas[i], &alloc)) {
+			return 1;
+		}
+
+		uint32_t file_count = 0;
+		for (int arg = 1; arg < argc; ++arg) {
+			if (!check_folder(argv[arg], isas[i], &file_count, &alloc)) {
+				return 1;
+			}
+		}
+
+		printf("%s: %u random buffers and %u files match\n", ISA_NAMES[isas[i]], TOKENIZE_TEST_RANDOM_BUFFERS, file_count);
+	}
+
+	return 0;
+}